@@ -1,10 +1,81 @@
 #include <nanobench.h>
 
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
 #include <sstream>
 #include <charconv> // from_chars
 #include <random>
 #include <climits>
+#include <cstdio>
+#include <cstring> // memchr
+#include <filesystem>
+#include <thread>
+#include <algorithm>
+#include <variant>
+#include <tuple>
+#include <limits>
+#include <type_traits>
+#include <cctype>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <new>
+#include <chrono>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define HAVE_X86_SIMD
+    #include <immintrin.h>
+    #ifndef _MSC_VER
+        #include <cpuid.h>
+    #endif
+#endif
+
+// MSVC lets you use any intrinsics anywhere, gcc and clang need to be told which functions may use them.
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define TARGET(isa)
+#else
+    #define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <io.h>
+    #include <fcntl.h>
+    #include <psapi.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+    #include <sched.h>
+#endif
+
+// optional, only needed for the numa mode, see CMakeLists.txt
+#ifdef HAVE_NUMA
+    #include <numa.h>
+#endif
+
+// optional too, for the compressed files
+#ifdef HAVE_ZLIB
+    #include <zlib.h>
+#endif
 
 
 // On windows size_t is long long unsigned int and on linux it is long unsigned int.
@@ -28,6 +99,46 @@ struct Result {
 };
 
 
+// Character classes looked up in a table instead of asking the locale aware isspace and isdigit.
+// The whitespace is the same as isspace in the "C" locale.
+enum CharClass : uint8_t {
+    char_space = 1,
+    char_digit = 2,
+    char_newline = 4
+};
+
+constexpr std::array<uint8_t, 256> make_char_classes() {
+    std::array<uint8_t, 256> classes{};
+    for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) {
+        classes[static_cast<unsigned char>(c)] |= char_space;
+    }
+    for (char c = '0'; c <= '9'; ++c) {
+        classes[static_cast<unsigned char>(c)] |= char_digit;
+    }
+    classes['\n'] |= char_newline;
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> char_classes = make_char_classes();
+
+inline bool has_class(char c, CharClass cls) {
+    return char_classes[static_cast<unsigned char>(c)] & cls;
+}
+
+inline bool is_space(char c) {
+    return has_class(c, char_space);
+}
+
+inline bool is_digit(char c) {
+    return has_class(c, char_digit);
+}
+
+// whitespace within a line
+inline bool is_blank(char c) {
+    return (char_classes[static_cast<unsigned char>(c)] & (char_space | char_newline)) == char_space;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////
 //                                                                                // 
 //                          BENCHMARKED IMPLEMENTATIONS                           //
@@ -223,154 +334,6700 @@ Result parse_custom(const std::string& str) {
 }
 
 
-////////////////////////////////////////////////////////////////////////////////////
-//                                                                                // 
-//                                TEST STUFF                                      //
-//                                                                                //
-////////////////////////////////////////////////////////////////////////////////////
+// The following two are the same as from_chars and custom, only using the lookup table for the character classes.
 
-bool operator==(Result a, Result b) {
-    if (a.err != b.err) {
-        return false;
+Result parse_from_chars_lut(const std::string& str) {
+    Result result;
+    size_t i = 0;
+
+    while (i < str.size() && is_space(str[i])) {
+        ++i;
+    }
+    if (i >= str.size()) {
+        result.err = ErrCode::empty;
+        return result;
     }
 
-    if (a.err != ErrCode::success) {
-        return true;
+    auto res = std::from_chars(&str[i], str.data() + str.size(), result.row);
+    if (res.ec == std::errc::invalid_argument || res.ec == std::errc::result_out_of_range) {
+        result.err = ErrCode::error;
+        return result;
     }
 
-    return a.col == b.col && a.row == b.row;
-}
+    i = res.ptr - str.data();
 
-bool operator!=(Result a, Result b) {
-    return !(a == b);
-}
+    while (i < str.size() && is_space(str[i])) {
+        ++i;
+    }
+    if (i >= str.size()) {
+        result.err = ErrCode::error;
+        return result;
+    }
 
-std::ostream& operator<<(std::ostream& out, Result res) {
-    switch (res.err) {
-        case ErrCode::empty:
-            out << "empty string";
-            break;
-        case ErrCode::error:
-            out << "error";
-            break;
-        case ErrCode::success:
-            out << res.row << " " << res.col;
-            break;
-        default:
-            out << "unknown";
+    res = std::from_chars(&str[i], str.data() + str.size(), result.col);
+    if (res.ec == std::errc::invalid_argument || res.ec == std::errc::result_out_of_range) {
+        result.err = ErrCode::error;
+        return result;
     }
-    return out;
+
+    result.err = ErrCode::success;
+    return result;
 }
 
-#define EARLY_RETURN(expr) \
-    if (true) {          \
-        if (!(expr)) {   \
-            return;      \
-        }                \
-    } else (void)0
+bool parse_single_lut(const std::string& str, size_t i, size_t& end, size_t& val) {
+    constexpr size_t max_val = size_t(-1);
+    constexpr size_t risky_val = max_val/10;
+    constexpr size_t max_digit = max_val % 10;
+    
+    size_t res = 0;
+    while(i < str.size() && is_digit(str[i])) {
+        size_t d = str[i] - '0';
+        if (res < risky_val || (res == risky_val && d <= max_digit)) {
+            res = res*10 + d;
+        } else {
+            return false;
+        }
+        ++i;
+    }
 
+    end = i;
+    val = res;
 
-std::mt19937 mt;
+    return true;
+}
 
-template<typename Func>
-void test_overflow(Func func, const std::string& test_name) {
-    size_t max_val = size_t(-1);
-    size_t critical_val = max_val/10;
+Result parse_custom_lut(const std::string& str) {
+    Result res;
+    size_t i = 0;
 
-    std::uniform_int_distribution<size_t> dist(critical_val + 1, max_val);
+    while (i < str.size() && is_space(str[i])) {
+        ++i;
+    }
 
-    for (size_t i = 0; i < 100'000; ++i) {
-        std::string str = std::to_string(dist(mt)) + "0 10";
-        auto res = func(str);
-        if (res.err != ErrCode::error) {
-            std::cout << "OVERFLOW TEST FAILED: " << test_name << "\n";
-            std::cout << "    Input: " << str << "\n";
-            return;
-        }
+    if (i >= str.size()) {
+        res.err = ErrCode::empty;
+        return res;
     }
-}
 
-template<typename Func>
-void test_parse_func(Func func, const std::string& test_name) {
+    if (!is_digit(str[i])) {
+        res.err = ErrCode::error;
+        return res;
+    }
 
-    auto test_single_input = [&] (const std::string& input, Result expected) {
-        Result actual = func(input);
-        if (actual != expected) {
-            std::cerr << "TEST FAILED: " << test_name << "\n";
-            std::cerr << "    On input: '" << input << "'\n";
-            std::cerr << "    Got:      " << actual << "\n";
-            std::cerr << "    Expected: " << expected << "\n";
-            return false;
-        }
-        return true;
-    };
+    size_t end;
+    if (!parse_single_lut(str, i, end, res.row)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+    i = end;
 
-    EARLY_RETURN( test_single_input("252165 1682156", { 252165, 1682156, ErrCode::success }) );
-    EARLY_RETURN( test_single_input("252165 1682156 1.00256", { 252165, 1682156, ErrCode::success }) );
-    EARLY_RETURN( test_single_input("252165 1682156 ???", { 252165, 1682156, ErrCode::success }) );
-    EARLY_RETURN( test_single_input(" \t 252165 \t 1682156 \t ", { 252165, 1682156, ErrCode::success }) );
+    while (i < str.size() && is_space(str[i])) {
+        ++i;
+    }
 
-    EARLY_RETURN( test_single_input("", { 0, 0, ErrCode::empty }) );
-    EARLY_RETURN( test_single_input("    \t\t   \n", { 0, 0, ErrCode::empty }) );
+    if (i >= str.size() || !is_digit(str[i])) {
+        res.err = ErrCode::error;
+        return res;
+    }
 
-    EARLY_RETURN( test_single_input(" k  11100 36 ", { 0, 0, ErrCode::error }) );
-    EARLY_RETURN( test_single_input(" 11100 ? 36 ", { 0, 0, ErrCode::error }) );
-    EARLY_RETURN( test_single_input("18446744073709551616 36", { 0, 0, ErrCode::error }) );
-    EARLY_RETURN( test_single_input("26 18446744073709551616", { 0, 0, ErrCode::error }) );
-    EARLY_RETURN( test_single_input("26 184467440737095516111", { 0, 0, ErrCode::error }) );
-    EARLY_RETURN( test_single_input("26 53197085087656854960", { 0, 0, ErrCode::error }) );
+    if (!parse_single_lut(str, i, end, res.col)) {
+        res.err = ErrCode::error;
+        return res;
+    }
 
-    std::cerr << "TEST PASSED: " << test_name << "\n";
+    res.err = ErrCode::success;
+    return res;
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////////
 //                                                                                // 
-//                                    MAIN                                        //
+//                          BUFFER BASED IMPLEMENTATIONS                          //
 //                                                                                //
 ////////////////////////////////////////////////////////////////////////////////////
 
-int main() {
-    test_parse_func(parse_string_stream, "stringstream");
-    test_parse_func(parse_custom, "custom");
-    test_parse_func(parse_sscanf, "sscanf");
-    test_parse_func(parse_strtoull, "strtoull");
-    test_parse_func(parse_from_chars, "from_chars");
+// These work directly on a buffer containing possibly many lines. They parse the line
+// starting at `begin` and set `next` to the beginning of the following line (or to `end`),
+// so a whole file can be walked without creating a std::string for every line.
 
-    // test overflows in a bit more detailed way for my custom implementation just to be sure
-    test_overflow(parse_custom, "custom");
+const char* find_line_end(const char* begin, const char* end) {
+    auto pos = static_cast<const char*>(memchr(begin, '\n', end - begin));
+    return pos ? pos : end;
+}
 
-    std::cerr << "\n";
+const char* next_line(const char* line_end, const char* end) {
+    return line_end == end ? end : line_end + 1;
+}
 
-    std::string test_str = "236514 159854 25.01564 ";
+// stringstream, sscanf and strtoull need a null terminated string, so the line is first copied
+// into a reused buffer. That way there is at least no allocation per line on our side.
+std::string& line_buffer(const char* begin, const char* end) {
+    thread_local std::string line;
+    line.assign(begin, end);
+    return line;
+}
 
-    auto bench = ankerl::nanobench::Bench();
+Result parse_string_stream_buf(const char* begin, const char* end, const char*& next) {
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    return parse_string_stream(line_buffer(begin, line_end));
+}
 
-    // on windows pyperf can't help us to setup the system for benechmarks
-    // so the benchmark is quite unstable and we have to use more iterations
-#ifdef _WIN32
-    bench = bench.minEpochIterations(200'000);
-#endif
-        
-    bench
-        .run("stringstream", [&] {
-            auto res = parse_string_stream(test_str);    
-            ankerl::nanobench::doNotOptimizeAway(res);
-        })
-        .run("sscanf", [&] {
-            auto res = parse_sscanf(test_str);    
-            ankerl::nanobench::doNotOptimizeAway(res);
-        })
-        .run("strtoull", [&] {
-            auto res = parse_strtoull(test_str);    
-            ankerl::nanobench::doNotOptimizeAway(res);
-        })
-        .run("from_chars", [&] {
-            auto res = parse_from_chars(test_str);    
-            ankerl::nanobench::doNotOptimizeAway(res);
-        })
-        .run("custom", [&] {
-            auto res = parse_custom(test_str);    
-            ankerl::nanobench::doNotOptimizeAway(res);
-        });
+Result parse_sscanf_buf(const char* begin, const char* end, const char*& next) {
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    return parse_sscanf(line_buffer(begin, line_end));
+}
+
+Result parse_strtoull_buf(const char* begin, const char* end, const char*& next) {
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    return parse_strtoull(line_buffer(begin, line_end));
+}
+
+Result parse_from_chars_buf(const char* begin, const char* end, const char*& next) {
+    Result result;
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    end = line_end;
+
+    const char* p = begin;
+
+    while (p < end && isspace(*p)) {
+        ++p;
+    }
+    if (p >= end) {
+        result.err = ErrCode::empty;
+        return result;
+    }
+
+    auto res = std::from_chars(p, end, result.row);
+    if (res.ec == std::errc::invalid_argument || res.ec == std::errc::result_out_of_range) {
+        result.err = ErrCode::error;
+        return result;
+    }
+
+    p = res.ptr;
+
+    while (p < end && isspace(*p)) {
+        ++p;
+    }
+    if (p >= end) {
+        result.err = ErrCode::error;
+        return result;
+    }
+
+    res = std::from_chars(p, end, result.col);
+    if (res.ec == std::errc::invalid_argument || res.ec == std::errc::result_out_of_range) {
+        result.err = ErrCode::error;
+        return result;
+    }
+
+    result.err = ErrCode::success;
+    return result;
+}
+
+bool parse_single_buf(const char* p, const char* end, const char*& out, size_t& val) {
+    // same overflow handling as in parse_single
+    constexpr size_t max_val = size_t(-1);
+    constexpr size_t risky_val = max_val/10;
+    constexpr size_t max_digit = max_val % 10;
+
+    size_t res = 0;
+    while (p < end && is_digit(*p)) {
+        size_t d = *p - '0';
+        if (res < risky_val || (res == risky_val && d <= max_digit)) {
+            res = res*10 + d;
+        } else {
+            return false;
+        }
+        ++p;
+    }
+
+    out = p;
+    val = res;
+
+    return true;
+}
+
+// The surrounding logic shared by the custom implementations, they differ only in how they parse a single number.
+using ParseSingleFunc = bool (*)(const char* p, const char* end, const char*& out, size_t& val);
+
+template<ParseSingleFunc parse_number>
+Result parse_indices_buf(const char* begin, const char* end, const char*& next) {
+    Result res;
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    end = line_end;
+
+    const char* p = begin;
+
+    while (p < end && is_space(*p)) {
+        ++p;
+    }
+
+    if (p >= end) {
+        res.err = ErrCode::empty;
+        return res;
+    }
+
+    if (!is_digit(*p)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+
+    if (!parse_number(p, end, p, res.row)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+
+    while (p < end && is_space(*p)) {
+        ++p;
+    }
+
+    if (p >= end || !is_digit(*p)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+
+    if (!parse_number(p, end, p, res.col)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+
+    res.err = ErrCode::success;
+    return res;
+}
+
+Result parse_custom_buf(const char* begin, const char* end, const char*& next) {
+    return parse_indices_buf<parse_single_buf>(begin, end, next);
+}
+
+// SWAR (SIMD within a register) version of parse_single. It loads 8 characters at once into
+// a uint64_t, finds how many of them are digits and converts all of them with a few multiplications.
+// It relies on the first character ending up in the lowest byte, so it needs a little endian machine.
+
+constexpr uint64_t swar_pow10[] = { 1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000 };
+
+unsigned count_trailing_zeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Number of consecutive digits at the beginning of the chunk.
+size_t swar_digit_count(uint64_t chunk) {
+    // a byte is a digit iff its upper nibble is 3 both before and after adding 6,
+    // so after the xor exactly the digits are zero (carries only go into bytes after a non-digit)
+    uint64_t x = ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) 
+                 ^ 0x3333333333333333;
+
+    // set the highest bit of every non-zero byte
+    uint64_t non_digits = (((x & 0x7F7F7F7F7F7F7F7F) + 0x7F7F7F7F7F7F7F7F) | x) & 0x8080808080808080;
+
+    return non_digits == 0 ? 8 : count_trailing_zeros(non_digits) / 8;
+}
+
+// Converts the first `len` (between 1 and 8) characters of the chunk, which must all be digits.
+uint64_t swar_convert(uint64_t chunk, size_t len) {
+    // move the digits to the top so the rest acts as leading zeros
+    uint64_t val = (chunk - 0x3030303030303030) << (8*(8 - len));
+
+    // combine neighbouring digits, then pairs of those and then pairs of those
+    val = (val * 10) + (val >> 8);
+    val = (((val & 0x000000FF000000FF) * 0x000F424000000064) + 
+           (((val >> 16) & 0x000000FF000000FF) * 0x0000271000000001)) >> 32;
+    return val;
+}
+
+bool parse_single_swar(const char* p, const char* end, const char*& out, size_t& val) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return parse_single_buf(p, end, out, val);
+#else
+    const char* start = p;
+    uint64_t res = 0;
+
+    while (end - p >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+
+        size_t len = swar_digit_count(chunk);
+        if (len == 0) {
+            break;
+        }
+
+        // up to 19 digits always fit, with more we might overflow and the precise loop has to decide
+        if (size_t(p - start) + len > 19) {
+            return parse_single_buf(start, end, out, val);
+        }
+
+        res = res*swar_pow10[len] + swar_convert(chunk, len);
+        p += len;
+
+        if (len < 8) {
+            out = p;
+            val = res;
+            return true;
+        }
+    }
+
+    // less than 8 characters left, finish one by one
+    constexpr size_t max_val = size_t(-1);
+    constexpr size_t risky_val = max_val/10;
+    constexpr size_t max_digit = max_val % 10;
+
+    while (p < end && is_digit(*p)) {
+        size_t d = *p - '0';
+        if (res < risky_val || (res == risky_val && d <= max_digit)) {
+            res = res*10 + d;
+        } else {
+            return false;
+        }
+        ++p;
+    }
+
+    out = p;
+    val = res;
+    return true;
+#endif
+}
+
+Result parse_swar_buf(const char* begin, const char* end, const char*& next) {
+    return parse_indices_buf<parse_single_swar>(begin, end, next);
+}
+
+Result parse_swar(const std::string& str) {
+    const char* next;
+    return parse_swar_buf(str.data(), str.data() + str.size(), next);
+}
+
+// parse_indices_buf finds the end of the line first and then parses the indices, so the indices get
+// scanned twice and the value once. Here the indices are parsed straight out of the buffer instead
+// (the whitespace in front of them just must not contain the newline) and `p` is left right after
+// the second one. The caller decides what happens with the rest of the line.
+template<ParseSingleFunc parse_number>
+Result parse_indices_prefix(const char* begin, const char* end, const char*& p) {
+    Result res;
+    p = begin;
+
+    while (p < end && is_blank(*p)) {
+        ++p;
+    }
+
+    if (p >= end || *p == '\n') {
+        res.err = ErrCode::empty;
+        return res;
+    }
+
+    if (!is_digit(*p) || !parse_number(p, end, p, res.row)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+
+    while (p < end && is_blank(*p)) {
+        ++p;
+    }
+
+    if (p >= end || !is_digit(*p) || !parse_number(p, end, p, res.col)) {
+        res.err = ErrCode::error;
+        return res;
+    }
+
+    res.err = ErrCode::success;
+    return res;
+}
+
+// Lines without a value end right after the second index, otherwise memchr jumps over the value.
+const char* skip_rest_of_line(const char* p, const char* end) {
+    if (p < end && *p == '\n') {
+        return p + 1;
+    }
+    return next_line(find_line_end(p, end), end);
+}
+
+template<ParseSingleFunc parse_number>
+Result parse_indices_skip_buf(const char* begin, const char* end, const char*& next) {
+    const char* p;
+    Result res = parse_indices_prefix<parse_number>(begin, end, p);
+    next = skip_rest_of_line(p, end);
+    return res;
+}
+
+Result parse_custom_skip_buf(const char* begin, const char* end, const char*& next) {
+    return parse_indices_skip_buf<parse_single_buf>(begin, end, next);
+}
+
+Result parse_swar_skip_buf(const char* begin, const char* end, const char*& next) {
+    return parse_indices_skip_buf<parse_single_swar>(begin, end, next);
+}
+
+// For when the value is actually needed, so we know what real valued matrices cost. A line without
+// a value is an error here. from_chars for double needs gcc 11 or msvc, elsewhere the line is copied
+// so strtod finds a null terminator.
+Result parse_value_buf(const char* begin, const char* end, const char*& next, double& value) {
+    const char* p;
+    Result res = parse_indices_prefix<parse_single_swar>(begin, end, p);
+    if (res.err != ErrCode::success) {
+        next = skip_rest_of_line(p, end);
+        return res;
+    }
+
+    while (p < end && is_blank(*p)) {
+        ++p;
+    }
+    // from_chars does not accept the plus sign
+    if (p < end && *p == '+') {
+        ++p;
+    }
+
+#if defined(__cpp_lib_to_chars)
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    bool ok = ec == std::errc() && (ptr == end || is_space(*ptr));
+#else
+    const char* line_end = find_line_end(p, end);
+    const std::string& line = line_buffer(p, line_end);
+    char* str_end;
+    value = strtod(line.c_str(), &str_end);
+    const char* ptr = p + (str_end - line.c_str());
+    bool ok = str_end != line.c_str() && (ptr == line_end || is_space(*ptr));
+#endif
+
+    next = skip_rest_of_line(ptr, end);
+    if (!ok) {
+        res.err = ErrCode::error;
+    }
+    return res;
+}
+
+
+// SIMD version which looks at 16 (SSE4.2) or 32 (AVX2) characters at once. It classifies all of them into
+// whitespace, digits and newlines, finds both indices from the resulting bit masks and converts each of them
+// with a couple of multiply-adds. Anything unusual (long numbers, errors, lines longer than the window,
+// the end of the buffer) is left to the custom implementation, so only the common case has to be fast.
+// The kernel is selected at startup based on what the cpu supports.
+
+using ParseBufFunc = Result (*)(const char* begin, const char* end, const char*& next);
+
+// Where the interesting parts of a line are within the window.
+struct LineShape {
+    unsigned row_begin;
+    unsigned row_len;
+    unsigned col_begin;
+    unsigned col_len;
+    // `width` if the newline is not in the window
+    unsigned line_end;
+};
+
+enum class LineKind {
+    indices,
+    empty,
+    fallback
+};
+
+// Bit i of each mask describes the i-th character of a window `width` characters long.
+LineKind find_line_shape(uint64_t space, uint64_t digit, uint64_t newline, unsigned width, LineShape& shape) {
+    const uint64_t all = (uint64_t(1) << width) - 1;
+    const uint64_t not_space = ~space & all;
+    const uint64_t not_digit = ~digit & all;
+
+    if (not_space == 0) {
+        return LineKind::fallback;
+    }
+
+    unsigned first = count_trailing_zeros(not_space);
+    if ((newline >> first) & 1) {
+        shape.line_end = first;
+        return LineKind::empty;
+    }
+    if (!((digit >> first) & 1)) {
+        return LineKind::fallback;
+    }
+
+    uint64_t rest = not_digit & (all << first);
+    if (rest == 0) {
+        return LineKind::fallback;
+    }
+    unsigned row_end = count_trailing_zeros(rest);
+
+    rest = not_space & (all << row_end);
+    if (rest == 0) {
+        return LineKind::fallback;
+    }
+    unsigned second = count_trailing_zeros(rest);
+    if (!((digit >> second) & 1)) {
+        return LineKind::fallback;
+    }
+
+    rest = not_digit & (all << second);
+    if (rest == 0) {
+        return LineKind::fallback;
+    }
+    unsigned col_end = count_trailing_zeros(rest);
+
+    // a single 16 byte register is used for the conversion and that is plenty for our indices
+    if (row_end - first > 16 || col_end - second > 16) {
+        return LineKind::fallback;
+    }
+
+    rest = newline & (all << col_end);
+
+    shape.row_begin = first;
+    shape.row_len = row_end - first;
+    shape.col_begin = second;
+    shape.col_len = col_end - second;
+    shape.line_end = rest == 0 ? width : count_trailing_zeros(rest);
+
+    return LineKind::indices;
+}
+
+#ifdef HAVE_X86_SIMD
+
+// Converts the first `len` (between 1 and 16) characters, which must all be digits.
+TARGET("sse4.2")
+uint64_t simd_convert(const char* p, unsigned len) {
+    const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    // shuffle the digits to the end of the register, the indices in front of them are negative
+    // so pshufb zeroes those and they act as leading zeros
+    __m128i shuffle = _mm_add_epi8(index, _mm_set1_epi8(static_cast<char>(int(len) - 16)));
+
+    __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+    digits = _mm_shuffle_epi8(digits, shuffle);
+
+    // 16 digits -> 8 two digit numbers -> 4 four digit numbers -> 2 eight digit numbers
+    __m128i pairs = _mm_maddubs_epi16(digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    quads = _mm_packus_epi32(quads, quads);
+    __m128i octets = _mm_madd_epi16(quads, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+
+    uint64_t hi = static_cast<uint32_t>(_mm_cvtsi128_si32(octets));
+    uint64_t lo = static_cast<uint32_t>(_mm_extract_epi32(octets, 1));
+    return hi*100'000'000 + lo;
+}
+
+TARGET("sse4.2")
+Result parse_sse42_buf(const char* begin, const char* end, const char*& next) {
+    constexpr unsigned width = 16;
+
+    // the conversion loads 16 bytes from anywhere in the window
+    if (end - begin < 2*width) {
+        return parse_custom_buf(begin, end, next);
+    }
+
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+
+    __m128i newline = _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n'));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), 
+                                  _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    // ' ' and '\t' to '\r' except for '\n'
+    __m128i space = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('\t' - 1)), 
+                                  _mm_cmplt_epi8(chars, _mm_set1_epi8('\r' + 1)));
+    space = _mm_or_si128(_mm_andnot_si128(newline, space), _mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')));
+
+    LineShape shape;
+    LineKind kind = find_line_shape(static_cast<uint32_t>(_mm_movemask_epi8(space)), 
+                                    static_cast<uint32_t>(_mm_movemask_epi8(digit)), 
+                                    static_cast<uint32_t>(_mm_movemask_epi8(newline)), width, shape);
+
+    if (kind == LineKind::fallback) {
+        return parse_custom_buf(begin, end, next);
+    }
+
+    if (kind == LineKind::empty) {
+        next = begin + shape.line_end + 1;
+        return { 0, 0, ErrCode::empty };
+    }
+
+    Result res;
+    res.row = simd_convert(begin + shape.row_begin, shape.row_len);
+    res.col = simd_convert(begin + shape.col_begin, shape.col_len);
+    res.err = ErrCode::success;
+
+    const char* line_end = shape.line_end < width ? begin + shape.line_end : find_line_end(begin + width, end);
+    next = next_line(line_end, end);
+
+    return res;
+}
+
+TARGET("avx2")
+Result parse_avx2_buf(const char* begin, const char* end, const char*& next) {
+    constexpr unsigned width = 32;
+
+    // the conversion loads 16 bytes from anywhere in the window
+    if (end - begin < width + 16) {
+        return parse_custom_buf(begin, end, next);
+    }
+
+    __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+
+    __m256i newline = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\n'));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), 
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    // ' ' and '\t' to '\r' except for '\n'
+    __m256i space = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('\t' - 1)), 
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), chars));
+    space = _mm256_or_si256(_mm256_andnot_si256(newline, space), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')));
+
+    uint32_t space_mask = _mm256_movemask_epi8(space);
+    uint32_t digit_mask = _mm256_movemask_epi8(digit);
+    uint32_t newline_mask = _mm256_movemask_epi8(newline);
+
+    // gcc does not do this on its own for functions with the target attribute and leaving the upper halves
+    // dirty makes any non-VEX SSE code executed afterwards (which is basically everything else) crawl
+    _mm256_zeroupper();
+
+    LineShape shape;
+    LineKind kind = find_line_shape(space_mask, digit_mask, newline_mask, width, shape);
+
+    if (kind == LineKind::fallback) {
+        return parse_custom_buf(begin, end, next);
+    }
+
+    if (kind == LineKind::empty) {
+        next = begin + shape.line_end + 1;
+        return { 0, 0, ErrCode::empty };
+    }
+
+    Result res;
+    res.row = simd_convert(begin + shape.row_begin, shape.row_len);
+    res.col = simd_convert(begin + shape.col_begin, shape.col_len);
+    res.err = ErrCode::success;
+
+    const char* line_end = shape.line_end < width ? begin + shape.line_end : find_line_end(begin + width, end);
+    next = next_line(line_end, end);
+
+    return res;
+}
+
+#endif
+
+bool cpu_has_sse42() {
+#if defined(HAVE_X86_SIMD) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return info[2] & (1 << 20);
+#elif defined(HAVE_X86_SIMD)
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+bool cpu_has_avx2() {
+#if defined(HAVE_X86_SIMD) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5));
+#elif defined(HAVE_X86_SIMD)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+struct SimdKernel {
+    const char* name;
+    ParseBufFunc func;
+};
+
+SimdKernel select_simd_kernel() {
+#ifdef HAVE_X86_SIMD
+    if (cpu_has_avx2()) {
+        return { "avx2", parse_avx2_buf };
+    }
+    if (cpu_has_sse42()) {
+        return { "sse4.2", parse_sse42_buf };
+    }
+#endif
+    return { "custom", parse_custom_buf };
+}
+
+const SimdKernel simd_kernel = select_simd_kernel();
+
+Result parse_simd_buf(const char* begin, const char* end, const char*& next) {
+    return simd_kernel.func(begin, end, next);
+}
+
+Result parse_simd(const std::string& str) {
+    const char* next;
+    return parse_simd_buf(str.data(), str.data() + str.size(), next);
+}
+
+// The custom implementation specialized at compile time on the type of the integers and the number
+// of integer fields at the beginning of the line (2 for matrices, 3 for tensors). Our matrices never
+// get anywhere near 2^32 rows so with uint32_t the overflow check can be a lot tighter.
+
+template<typename T>
+struct DigitLimits {
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "only integers are supported");
+
+    // the digits are accumulated as the unsigned type of the same width, the sign is applied at the end
+    using Unsigned = std::make_unsigned_t<T>;
+
+    static constexpr Unsigned max_val = static_cast<Unsigned>(std::numeric_limits<T>::max());
+    static constexpr Unsigned risky_val = max_val/10;
+    static constexpr Unsigned max_digit = max_val % 10;
+
+    // the magnitude of the smallest value, one more than the largest one for the signed types
+    static constexpr Unsigned min_magnitude = std::is_signed_v<T> ? static_cast<Unsigned>(max_val + 1) : 0;
+    static constexpr Unsigned min_risky_val = min_magnitude/10;
+    static constexpr Unsigned min_max_digit = min_magnitude % 10;
+};
+
+// The custom implementation for any integer type. The signed types take a '-' in front of the digits,
+// no '+' just like from_chars.
+template<typename T>
+bool parse_single_typed(const char* p, const char* end, const char*& out, T& val) {
+    using Limits = DigitLimits<T>;
+    using Unsigned = typename Limits::Unsigned;
+
+    bool negative = false;
+    if constexpr (std::is_signed_v<T>) {
+        if (p < end && *p == '-') {
+            negative = true;
+            ++p;
+            if (p >= end || !is_digit(*p)) {
+                return false;
+            }
+        }
+    }
+    const Unsigned risky_val = negative ? Limits::min_risky_val : Limits::risky_val;
+    const Unsigned max_digit = negative ? Limits::min_max_digit : Limits::max_digit;
+
+    Unsigned res = 0;
+    while (p < end && is_digit(*p)) {
+        Unsigned d = static_cast<Unsigned>(*p - '0');
+        if (res < risky_val || (res == risky_val && d <= max_digit)) {
+            res = static_cast<Unsigned>(res*10 + d);
+        } else {
+            return false;
+        }
+        ++p;
+    }
+
+    out = p;
+    val = static_cast<T>(negative ? static_cast<Unsigned>(0 - res) : res);
+
+    return true;
+}
+
+// Skips the whitespace in front of a field and parses it, moving `p` past the field.
+struct CustomField {
+    template<typename T>
+    bool operator()(const char*& p, const char* end, T& val) const {
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        bool starts_number = p < end && (is_digit(*p) || (std::is_signed_v<T> && *p == '-'));
+        return starts_number && parse_single_typed(p, end, p, val);
+    }
+};
+
+// The same with from_chars, to see whether the custom implementation is still worth it for a type.
+struct FromCharsField {
+    template<typename T>
+    bool operator()(const char*& p, const char* end, T& val) const {
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        auto res = std::from_chars(p, end, val);
+        p = res.ptr;
+        return res.ec == std::errc();
+    }
+};
+
+template<typename T, size_t N>
+struct FieldsResult {
+    // zeroed, so the fields of an empty or wrong line are well-defined
+    std::array<T, N> fields{};
+    ErrCode err;
+};
+
+template<typename T, size_t N>
+FieldsResult<T, N> parse_fields_buf(const char* begin, const char* end, const char*& next) {
+    FieldsResult<T, N> res;
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    end = line_end;
+
+    const char* p = begin;
+
+    while (p < end && is_space(*p)) {
+        ++p;
+    }
+
+    if (p >= end) {
+        res.err = ErrCode::empty;
+        return res;
+    }
+
+    for (size_t i = 0; i < N; ++i) {
+        if (!CustomField()(p, end, res.fields[i])) {
+            // the fields before the wrong one were parsed already
+            return { {}, ErrCode::error };
+        }
+    }
+
+    res.err = ErrCode::success;
+    return res;
+}
+
+// Fields of different types, e.g. the two indices followed by a signed weight as some graph formats have them.
+template<typename... Ts>
+struct TupleResult {
+    std::tuple<Ts...> fields;
+    ErrCode err;
+};
+
+template<typename FieldParser, typename... Ts>
+TupleResult<Ts...> parse_tuple_with(const char* begin, const char* end, const char*& next) {
+    TupleResult<Ts...> res{};
+    const char* line_end = find_line_end(begin, end);
+    next = next_line(line_end, end);
+    end = line_end;
+
+    const char* p = begin;
+
+    while (p < end && is_space(*p)) {
+        ++p;
+    }
+
+    if (p >= end) {
+        res.err = ErrCode::empty;
+        return res;
+    }
+
+    // the fields are parsed from left to right and the first one which fails stops it
+    FieldParser parse_field;
+    bool ok = std::apply([&] (auto&... fields) { return (parse_field(p, end, fields) && ...); }, res.fields);
+
+    res.err = ok ? ErrCode::success : ErrCode::error;
+    return res;
+}
+
+template<typename... Ts>
+TupleResult<Ts...> parse_tuple_buf(const char* begin, const char* end, const char*& next) {
+    return parse_tuple_with<CustomField, Ts...>(begin, end, next);
+}
+
+template<typename... Ts>
+TupleResult<Ts...> parse_tuple_from_chars_buf(const char* begin, const char* end, const char*& next) {
+    return parse_tuple_with<FromCharsField, Ts...>(begin, end, next);
+}
+
+// The two field version with the usual Result, so it can be used anywhere the other implementations are.
+template<typename T>
+Result parse_typed_buf(const char* begin, const char* end, const char*& next) {
+    auto res = parse_fields_buf<T, 2>(begin, end, next);
+    return { res.fields[0], res.fields[1], res.err };
+}
+
+// The batch version fills up to N lines at once. Every line gets a slot, the slots of empty and wrong
+// lines are zeroed and marked in the bitmaps instead (bit i%64 of word i/64 for the i-th line of the
+// batch), so the caller can handle the common case where everything parsed fine without looking at
+// every line. The lines themselves are still parsed one by one by the per line kernel.
+template<size_t N>
+struct LineBatch {
+    static_assert(N % 64 == 0, "the bitmaps are made of whole words");
+
+    std::array<size_t, N> rows;
+    std::array<size_t, N> cols;
+    std::array<uint64_t, N/64> empty;
+    std::array<uint64_t, N/64> errors;
+    size_t count = 0;
+
+    bool all_success() const {
+        uint64_t any = 0;
+        for (size_t i = 0; i < N/64; ++i) {
+            any |= empty[i] | errors[i];
+        }
+        return any == 0;
+    }
+};
+
+unsigned popcount(uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return static_cast<unsigned>(__popcnt64(x));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// Fills `batch` with the lines starting at `begin`, stops after N lines or at the end of the buffer.
+// Sets `next` to the first line which did not fit and returns the number of lines parsed.
+template<size_t N, ParseBufFunc parse_line>
+size_t parse_batch_buf(const char* begin, const char* end, const char*& next, LineBatch<N>& batch) {
+    batch.empty.fill(0);
+    batch.errors.fill(0);
+
+    const char* p = begin;
+    size_t i = 0;
+    for (; i < N && p < end; ++i) {
+        Result res = parse_line(p, end, p);
+        bool ok = res.err == ErrCode::success;
+        batch.rows[i] = ok ? res.row : 0;
+        batch.cols[i] = ok ? res.col : 0;
+        uint64_t bit = uint64_t(1) << (i % 64);
+        batch.empty[i/64] |= res.err == ErrCode::empty ? bit : 0;
+        batch.errors[i/64] |= res.err == ErrCode::error ? bit : 0;
+    }
+
+    batch.count = i;
+    next = p;
+    return i;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                TEST STUFF                                      //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+bool operator==(Result a, Result b) {
+    if (a.err != b.err) {
+        return false;
+    }
+
+    if (a.err != ErrCode::success) {
+        return true;
+    }
+
+    return a.col == b.col && a.row == b.row;
+}
+
+bool operator!=(Result a, Result b) {
+    return !(a == b);
+}
+
+std::ostream& operator<<(std::ostream& out, Result res) {
+    switch (res.err) {
+        case ErrCode::empty:
+            out << "empty string";
+            break;
+        case ErrCode::error:
+            out << "error";
+            break;
+        case ErrCode::success:
+            out << res.row << " " << res.col;
+            break;
+        default:
+            out << "unknown";
+    }
+    return out;
+}
+
+#define EARLY_RETURN(expr) \
+    if (true) {          \
+        if (!(expr)) {   \
+            return;      \
+        }                \
+    } else (void)0
+
+
+std::mt19937 mt;
+
+template<typename Func>
+void test_overflow(Func func, const std::string& test_name) {
+    size_t max_val = size_t(-1);
+    size_t critical_val = max_val/10;
+
+    std::uniform_int_distribution<size_t> dist(critical_val + 1, max_val);
+
+    for (size_t i = 0; i < 100'000; ++i) {
+        std::string str = std::to_string(dist(mt)) + "0 10";
+        auto res = func(str);
+        if (res.err != ErrCode::error) {
+            std::cout << "OVERFLOW TEST FAILED: " << test_name << "\n";
+            std::cout << "    Input: " << str << "\n";
+            return;
+        }
+    }
+}
+
+template<typename Func>
+void test_parse_func(Func func, const std::string& test_name) {
+
+    auto test_single_input = [&] (const std::string& input, Result expected) {
+        Result actual = func(input);
+        if (actual != expected) {
+            std::cerr << "TEST FAILED: " << test_name << "\n";
+            std::cerr << "    On input: '" << input << "'\n";
+            std::cerr << "    Got:      " << actual << "\n";
+            std::cerr << "    Expected: " << expected << "\n";
+            return false;
+        }
+        return true;
+    };
+
+    EARLY_RETURN( test_single_input("252165 1682156", { 252165, 1682156, ErrCode::success }) );
+    EARLY_RETURN( test_single_input("252165 1682156 1.00256", { 252165, 1682156, ErrCode::success }) );
+    EARLY_RETURN( test_single_input("252165 1682156 ???", { 252165, 1682156, ErrCode::success }) );
+    EARLY_RETURN( test_single_input(" \t 252165 \t 1682156 \t ", { 252165, 1682156, ErrCode::success }) );
+    EARLY_RETURN( test_single_input("12345678 87654321", { 12345678, 87654321, ErrCode::success }) );
+    EARLY_RETURN( test_single_input("1234567812345678 8765432187654321 1.0", { 1234567812345678, 8765432187654321, ErrCode::success }) );
+    EARLY_RETURN( test_single_input("18446744073709551615 1", { 18446744073709551615u, 1, ErrCode::success }) );
+    EARLY_RETURN( test_single_input("000000000000000000000012 5", { 12, 5, ErrCode::success }) );
+
+    EARLY_RETURN( test_single_input("", { 0, 0, ErrCode::empty }) );
+    EARLY_RETURN( test_single_input("    \t\t   \n", { 0, 0, ErrCode::empty }) );
+
+    EARLY_RETURN( test_single_input(" k  11100 36 ", { 0, 0, ErrCode::error }) );
+    EARLY_RETURN( test_single_input(" 11100 ? 36 ", { 0, 0, ErrCode::error }) );
+    EARLY_RETURN( test_single_input("18446744073709551616 36", { 0, 0, ErrCode::error }) );
+    EARLY_RETURN( test_single_input("26 18446744073709551616", { 0, 0, ErrCode::error }) );
+    EARLY_RETURN( test_single_input("26 184467440737095516111", { 0, 0, ErrCode::error }) );
+    EARLY_RETURN( test_single_input("26 53197085087656854960", { 0, 0, ErrCode::error }) );
+
+    std::cerr << "TEST PASSED: " << test_name << "\n";
+}
+
+
+// The generic tests only work for two 64-bit fields, these cover the other instantiations.
+void test_fields_funcs() {
+    auto test_single_input = [&] (auto func, const std::string& test_name, const std::string& input, auto expected) {
+        const char* next;
+        auto actual = func(input.data(), input.data() + input.size(), next);
+        if (actual.err != expected.err || (actual.err == ErrCode::success && actual.fields != expected.fields)) {
+            std::cerr << "TEST FAILED: " << test_name << "\n";
+            std::cerr << "    On input: '" << input << "'\n";
+            return false;
+        }
+        return true;
+    };
+
+    using Fields32 = FieldsResult<uint32_t, 2>;
+    auto parse32 = parse_fields_buf<uint32_t, 2>;
+    EARLY_RETURN( test_single_input(parse32, "fields<uint32_t, 2>", "252165 1682156 1.0", Fields32{ { 252165, 1682156 }, ErrCode::success }) );
+    EARLY_RETURN( test_single_input(parse32, "fields<uint32_t, 2>", "4294967295 0", Fields32{ { 4294967295u, 0 }, ErrCode::success }) );
+    EARLY_RETURN( test_single_input(parse32, "fields<uint32_t, 2>", " \t ", Fields32{ { 0, 0 }, ErrCode::empty }) );
+    EARLY_RETURN( test_single_input(parse32, "fields<uint32_t, 2>", "4294967296 0", Fields32{ { 0, 0 }, ErrCode::error }) );
+    EARLY_RETURN( test_single_input(parse32, "fields<uint32_t, 2>", "1 42949672950", Fields32{ { 0, 0 }, ErrCode::error }) );
+    EARLY_RETURN( test_single_input(parse32, "fields<uint32_t, 2>", "1 x", Fields32{ { 0, 0 }, ErrCode::error }) );
+    std::cerr << "TEST PASSED: fields<uint32_t, 2>\n";
+
+    using Fields3 = FieldsResult<uint64_t, 3>;
+    auto parse3 = parse_fields_buf<uint64_t, 3>;
+    EARLY_RETURN( test_single_input(parse3, "fields<uint64_t, 3>", "1 2 3 4.5", Fields3{ { 1, 2, 3 }, ErrCode::success }) );
+    EARLY_RETURN( test_single_input(parse3, "fields<uint64_t, 3>", "\t1  2\t 18446744073709551615", Fields3{ { 1, 2, 18446744073709551615u }, ErrCode::success }) );
+    EARLY_RETURN( test_single_input(parse3, "fields<uint64_t, 3>", "", Fields3{ { 0, 0, 0 }, ErrCode::empty }) );
+    EARLY_RETURN( test_single_input(parse3, "fields<uint64_t, 3>", "1 2", Fields3{ { 0, 0, 0 }, ErrCode::error }) );
+    EARLY_RETURN( test_single_input(parse3, "fields<uint64_t, 3>", "1 2 4.5", Fields3{ { 1, 2, 4 }, ErrCode::success }) );
+    EARLY_RETURN( test_single_input(parse3, "fields<uint64_t, 3>", "1 2 18446744073709551616", Fields3{ { 0, 0, 0 }, ErrCode::error }) );
+    std::cerr << "TEST PASSED: fields<uint64_t, 3>\n";
+}
+
+// Random values of the whole range of T, formatted the way they would be in a file.
+template<typename T>
+std::string random_value_string() {
+    if constexpr (std::is_signed_v<T>) {
+        return std::to_string(std::uniform_int_distribution<long long>(std::numeric_limits<T>::min(), 
+                                                                       std::numeric_limits<T>::max())(mt));
+    } else {
+        return std::to_string(std::uniform_int_distribution<unsigned long long>(0, std::numeric_limits<T>::max())(mt));
+    }
+}
+
+// The custom and the from_chars version have to agree for every type, also just outside of its range.
+template<typename T>
+bool test_typed_against_from_chars(const std::string& test_name) {
+    using Limits = std::numeric_limits<T>;
+    std::vector<std::string> inputs = {
+        std::to_string(+Limits::max()), std::to_string(+Limits::min()), "0", "-0", "-", "- 1", "--1", "+1", "1-",
+    };
+    if constexpr (sizeof(T) < 8) {
+        inputs.push_back(std::to_string(static_cast<long long>(Limits::max()) + 1));
+        inputs.push_back(std::to_string(static_cast<long long>(Limits::min()) - 1));
+    } else {
+        inputs.push_back(std::is_signed_v<T> ? "9223372036854775808" : "18446744073709551616");
+        inputs.push_back("-9223372036854775809");
+    }
+    for (size_t i = 0; i < 10'000; ++i) {
+        inputs.push_back(random_value_string<T>());
+    }
+
+    for (const auto& value : inputs) {
+        std::string input = " " + value + "\t" + value + " 1.5";
+        const char* next;
+        auto expected = parse_tuple_from_chars_buf<T, T>(input.data(), input.data() + input.size(), next);
+        auto actual = parse_tuple_buf<T, T>(input.data(), input.data() + input.size(), next);
+        auto fields = parse_fields_buf<T, 2>(input.data(), input.data() + input.size(), next);
+        bool same = actual.err == expected.err && fields.err == expected.err &&
+                    (expected.err != ErrCode::success || (actual.fields == expected.fields && 
+                     std::get<0>(expected.fields) == fields.fields[0] && std::get<1>(expected.fields) == fields.fields[1]));
+        if (!same) {
+            std::cerr << "TEST FAILED: " << test_name << "\n";
+            std::cerr << "    On input: '" << input << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_typed_funcs() {
+    bool ok = test_typed_against_from_chars<int8_t>("fields<int8_t, 2>") &&
+              test_typed_against_from_chars<uint8_t>("fields<uint8_t, 2>") &&
+              test_typed_against_from_chars<int16_t>("fields<int16_t, 2>") &&
+              test_typed_against_from_chars<uint16_t>("fields<uint16_t, 2>") &&
+              test_typed_against_from_chars<int32_t>("fields<int32_t, 2>") &&
+              test_typed_against_from_chars<uint32_t>("fields<uint32_t, 2>") &&
+              test_typed_against_from_chars<int64_t>("fields<int64_t, 2>") &&
+              test_typed_against_from_chars<uint64_t>("fields<uint64_t, 2>");
+    if (!ok) {
+        return;
+    }
+
+    auto fail = [] (const std::string& input) {
+        std::cerr << "TEST FAILED: tuple<uint32_t, uint32_t, int64_t>\n";
+        std::cerr << "    On input: '" << input << "'\n";
+    };
+    auto parse = [] (const std::string& input) {
+        const char* next;
+        return parse_tuple_buf<uint32_t, uint32_t, int64_t>(input.data(), input.data() + input.size(), next);
+    };
+
+    using Fields = std::tuple<uint32_t, uint32_t, int64_t>;
+    for (const auto& [input, fields, err] : std::vector<std::tuple<std::string, Fields, ErrCode>>{
+            { "3 4 -17", { 3, 4, -17 }, ErrCode::success },
+            { "  3\t4 -9223372036854775808 x", { 3, 4, std::numeric_limits<int64_t>::min() }, ErrCode::success },
+            { " \t ", {}, ErrCode::empty },
+            { "3 -4 17", {}, ErrCode::error },
+            { "3 4", {}, ErrCode::error },
+            { "4294967296 4 1", {}, ErrCode::error },
+            { "3 4 -", {}, ErrCode::error },
+        }) {
+        auto res = parse(input);
+        if (res.err != err || (err == ErrCode::success && res.fields != fields)) {
+            return fail(input);
+        }
+    }
+
+    std::cerr << "TEST PASSED: signed and unsigned fields from 8 to 64 bits\n";
+}
+
+void test_value_func() {
+    auto test_single_input = [] (const std::string& input, Result expected, double expected_value) {
+        const char* next;
+        double value = 0;
+        Result actual = parse_value_buf(input.data(), input.data() + input.size(), next, value);
+        if (actual != expected || (actual.err == ErrCode::success && value != expected_value)) {
+            std::cerr << "TEST FAILED: value\n";
+            std::cerr << "    On input: '" << input << "'\n";
+            std::cerr << "    Got:      " << actual << " " << value << "\n";
+            return false;
+        }
+        if (next != input.data() + input.size()) {
+            std::cerr << "TEST FAILED: value\n";
+            std::cerr << "    Did not skip the whole line: '" << input << "'\n";
+            return false;
+        }
+        return true;
+    };
+
+    EARLY_RETURN( test_single_input("252165 1682156 25.01564", { 252165, 1682156, ErrCode::success }, 25.01564) );
+    EARLY_RETURN( test_single_input("1 2\t-1e+02 \n", { 1, 2, ErrCode::success }, -100.0) );
+    EARLY_RETURN( test_single_input("  1   2   +0.5\r\n", { 1, 2, ErrCode::success }, 0.5) );
+    EARLY_RETURN( test_single_input("1 2 3", { 1, 2, ErrCode::success }, 3.0) );
+    EARLY_RETURN( test_single_input(" \t \n", { 0, 0, ErrCode::empty }, 0) );
+    EARLY_RETURN( test_single_input("1 2\n", { 1, 2, ErrCode::error }, 0) );
+    EARLY_RETURN( test_single_input("1 2 x\n", { 1, 2, ErrCode::error }, 0) );
+    EARLY_RETURN( test_single_input("1 2 3.5x\n", { 1, 2, ErrCode::error }, 0) );
+    EARLY_RETURN( test_single_input("1 x 3.5\n", { 1, 0, ErrCode::error }, 0) );
+    std::cerr << "TEST PASSED: value\n";
+}
+
+template<ParseBufFunc parse_line>
+void test_batch_func(const std::string& test_name) {
+    auto fail = [&] (const std::string& reason) {
+        std::cerr << "TEST FAILED: " << test_name << "\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    // enough lines for a couple of full batches and a partial one at the end
+    std::string buffer;
+    std::vector<Result> expected;
+    for (int i = 0; i < 20; ++i) {
+        buffer += "252165 1682156 1.5\n\n \t \n7 8\n k 1 2\r\n11 12 ???\n";
+        expected.insert(expected.end(), {
+            { 252165, 1682156, ErrCode::success },
+            { 0, 0, ErrCode::empty },
+            { 0, 0, ErrCode::empty },
+            { 7, 8, ErrCode::success },
+            { 0, 0, ErrCode::error },
+            { 11, 12, ErrCode::success },
+        });
+    }
+    buffer += "13 14";
+    expected.push_back({ 13, 14, ErrCode::success });
+
+    LineBatch<64> batch;
+    const char* p = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+    size_t line = 0;
+    while (p < end) {
+        size_t count = parse_batch_buf<64, parse_line>(p, end, p, batch);
+        if (count == 0 || count != batch.count || (count < 64 && p != end)) {
+            return fail("wrong number of lines in the batch: " + std::to_string(count));
+        }
+
+        for (size_t i = 0; i < count; ++i, ++line) {
+            uint64_t bit = uint64_t(1) << (i % 64);
+            bool empty = batch.empty[i/64] & bit;
+            bool error = batch.errors[i/64] & bit;
+            ErrCode err = empty ? ErrCode::empty : error ? ErrCode::error : ErrCode::success;
+            Result actual = { batch.rows[i], batch.cols[i], err };
+
+            if (line >= expected.size() || (empty && error) || actual != expected[line]) {
+                return fail("wrong result on line " + std::to_string(line));
+            }
+            if (err != ErrCode::success && (batch.rows[i] != 0 || batch.cols[i] != 0)) {
+                return fail("slot of a failed line not zeroed on line " + std::to_string(line));
+            }
+        }
+    }
+
+    if (line != expected.size()) {
+        return fail("wrong number of lines");
+    }
+
+    std::cerr << "TEST PASSED: " << test_name << "\n";
+}
+
+// Makes a buffer based implementation usable with the tests written for the string ones.
+template<typename BufFunc>
+auto as_string_func(BufFunc func) {
+    return [func] (const std::string& str) {
+        const char* next;
+        return func(str.data(), str.data() + str.size(), next);
+    };
+}
+
+// Checks that a buffer based implementation correctly moves from one line to the next.
+template<typename BufFunc>
+void test_buffer_func(BufFunc func, const std::string& test_name) {
+    test_parse_func(as_string_func(func), test_name);
+
+    std::string buffer = "252165 1682156 1.5\n\n \t \n7 8\n k 1 2\r\n11 12 ???\n13 14";
+    std::vector<Result> expected = {
+        { 252165, 1682156, ErrCode::success },
+        { 0, 0, ErrCode::empty },
+        { 0, 0, ErrCode::empty },
+        { 7, 8, ErrCode::success },
+        { 0, 0, ErrCode::error },
+        { 11, 12, ErrCode::success },
+        { 13, 14, ErrCode::success },
+    };
+
+    const char* p = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        Result actual = func(p, end, p);
+        if (actual != expected[i]) {
+            std::cerr << "BUFFER TEST FAILED: " << test_name << "\n";
+            std::cerr << "    On line:  " << i << "\n";
+            std::cerr << "    Got:      " << actual << "\n";
+            std::cerr << "    Expected: " << expected[i] << "\n";
+            return;
+        }
+    }
+
+    if (p != end) {
+        std::cerr << "BUFFER TEST FAILED: " << test_name << "\n";
+        std::cerr << "    Did not stop at the end of the buffer\n";
+        return;
+    }
+
+    std::cerr << "BUFFER TEST PASSED: " << test_name << "\n";
+}
+
+// The SIMD kernels only do the interesting work when they have enough of a buffer in front of them,
+// on a short string they would just fall back to the custom implementation. So the line is followed
+// by a newline and some padding.
+template<typename BufFunc>
+auto as_padded_string_func(BufFunc func) {
+    return [func] (const std::string& str) {
+        std::string padded = str + "\n" + std::string(64, ' ');
+        const char* next;
+        return func(padded.data(), padded.data() + padded.size(), next);
+    };
+}
+
+// Same as test_buffer_func plus all the tests with padding.
+template<typename BufFunc>
+void test_simd_func(BufFunc func, const std::string& test_name) {
+    test_buffer_func(func, test_name);
+    test_parse_func(as_padded_string_func(func), test_name + " padded");
+    test_overflow(as_padded_string_func(func), test_name + " padded");
+}
+
+// Random lines for the differential tests. Mostly two indices with some whitespace in between, but with
+// everything which could trip up one of the implementations mixed in: long runs of digits, leading
+// zeros, values right around size_t(-1), all kinds of whitespace, signs and junk anywhere in the line.
+std::string random_line() {
+    static const char* const edges[] = {
+        "18446744073709551615", "18446744073709551614", "18446744073709551616", "18446744073709551619",
+        "18446744073709551620", "18446744073709551700", "18446744073709552615", "18446744073709561615",
+        "19446744073709551615", "99999999999999999999", "10000000000000000000", "1844674407370955161",
+        "9999999999999999999", "184467440737095516150", "100000000000000000000",
+    };
+    static const char blanks[] = " \t\v\f\r";
+    static const char junk[] = "0123456789 \t\v\f\r+-.eEx#;";
+
+    std::uniform_int_distribution<int> percent_dist(0, 99);
+    auto pick = [&] (const char* chars, size_t n) {
+        return chars[std::uniform_int_distribution<size_t>(0, n - 1)(mt)];
+    };
+
+    auto whitespace = [&] (std::string& line, size_t max) {
+        size_t n = std::uniform_int_distribution<size_t>(0, max)(mt);
+        for (size_t i = 0; i < n; ++i) {
+            line += pick(blanks, sizeof(blanks) - 1);
+        }
+    };
+
+    auto number = [&] (std::string& line) {
+        int p = percent_dist(mt);
+        if (p < 10) {
+            line += std::string(std::uniform_int_distribution<size_t>(1, 8)(mt), '0');
+        }
+        if (p < 5) {
+            line += pick("+-", 2);
+        }
+        if (p >= 75) {
+            line += edges[std::uniform_int_distribution<size_t>(0, std::size(edges) - 1)(mt)];
+            return;
+        }
+        // the SWAR and SIMD versions switch strategies at 8, 16 and 19 digits
+        size_t digits = std::uniform_int_distribution<size_t>(1, 24)(mt);
+        for (size_t i = 0; i < digits; ++i) {
+            line += static_cast<char>('0' + std::uniform_int_distribution<int>(0, 9)(mt));
+        }
+    };
+
+    std::string line;
+    int kind = percent_dist(mt);
+    if (kind < 3) {
+        return line;
+    }
+    if (kind < 6) {
+        whitespace(line, 8);
+        return line;
+    }
+    if (kind < 10) {
+        size_t n = std::uniform_int_distribution<size_t>(1, 40)(mt);
+        for (size_t i = 0; i < n; ++i) {
+            line += pick(junk, sizeof(junk) - 1);
+        }
+        return line;
+    }
+
+    whitespace(line, 3);
+    number(line);
+    if (percent_dist(mt) < 95) {
+        line += pick(blanks, sizeof(blanks) - 1);
+    }
+    whitespace(line, 3);
+    if (percent_dist(mt) < 95) {
+        number(line);
+    }
+
+    int tail = percent_dist(mt);
+    if (tail < 40) {
+        whitespace(line, 3);
+    } else if (tail < 80) {
+        line += " 1.5e3";
+    } else {
+        size_t n = std::uniform_int_distribution<size_t>(1, 4)(mt);
+        for (size_t i = 0; i < n; ++i) {
+            line += pick(junk, sizeof(junk) - 1);
+        }
+    }
+
+    // and once in a while a random character somewhere in the middle of it all
+    if (percent_dist(mt) < 5) {
+        line[std::uniform_int_distribution<size_t>(0, line.size() - 1)(mt)] = pick(junk, sizeof(junk) - 1);
+    }
+    return line;
+}
+
+// Collects the differences to from_chars, only the first few are printed in full.
+struct Differences {
+    size_t count = 0;
+    size_t max_reports = 5;
+
+    void add(const std::string& name, const std::string& line, Result actual, Result expected) {
+        if (count++ >= max_reports) {
+            return;
+        }
+        std::string shown;
+        for (char c : line) {
+            if (c == '\t') shown += "\\t";
+            else if (c == '\v') shown += "\\v";
+            else if (c == '\f') shown += "\\f";
+            else if (c == '\r') shown += "\\r";
+            else shown += c;
+        }
+        std::cerr << "DIFFERENTIAL TEST FAILED: " << name << "\n";
+        std::cerr << "    On input: '" << shown << "'\n";
+        std::cerr << "    Got:      " << actual << "\n";
+        std::cerr << "    Expected: " << expected << "\n";
+    }
+};
+
+// stringstream, sscanf and strtoull take a sign in front of a number (and negate it for '-'), that is
+// how they are specified and nothing we could change. So lines with signs are not compared for them.
+bool has_sign(const std::string& line) {
+    return line.find_first_of("+-") != std::string::npos;
+}
+
+template<ParseBufFunc parse_line>
+void check_batches(const std::string& name, const std::string& buffer, const std::vector<std::string>& lines,
+                   const std::vector<Result>& expected, Differences& diffs) {
+    LineBatch<256> batch;
+    const char* p = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+    size_t line = 0;
+    while (p < end && line < lines.size()) {
+        size_t count = parse_batch_buf<256, parse_line>(p, end, p, batch);
+        for (size_t i = 0; i < count && line < lines.size(); ++i, ++line) {
+            uint64_t bit = uint64_t(1) << (i % 64);
+            bool empty = batch.empty[i/64] & bit;
+            bool error = batch.errors[i/64] & bit;
+            ErrCode err = empty ? ErrCode::empty : error ? ErrCode::error : ErrCode::success;
+            Result actual = { batch.rows[i], batch.cols[i], err };
+            bool zeroed = err == ErrCode::success || (batch.rows[i] == 0 && batch.cols[i] == 0);
+            if ((empty && error) || !zeroed || actual != expected[line]) {
+                diffs.add(name, lines[line], actual, expected[line]);
+            }
+        }
+    }
+    if (line != lines.size() || p != end) {
+        diffs.add(name + " (did not end with the buffer)", "", {}, {});
+    }
+}
+
+// Compares every implementation against from_chars on the given lines. The string ones get one line at a
+// time, the buffer ones and the batches all of them in a single buffer, so moving from one line to the
+// next is checked as well. Only the value parsing is left out, it wants a value on every line.
+size_t run_differential(const std::vector<std::string>& lines, Differences& diffs) {
+    std::vector<Result> expected(lines.size());
+    std::string buffer;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        expected[i] = parse_from_chars(lines[i]);
+        buffer += lines[i];
+        buffer += '\n';
+    }
+
+    using StringFunc = Result (*)(const std::string&);
+    struct StringKernel { const char* name; StringFunc func; bool takes_signs; };
+    const StringKernel string_kernels[] = {
+        { "stringstream", parse_string_stream, true },
+        { "sscanf", parse_sscanf, true },
+        { "strtoull", parse_strtoull, true },
+        { "from_chars lut", parse_from_chars_lut, false },
+        { "custom", parse_custom, false },
+        { "custom lut", parse_custom_lut, false },
+        { "swar", parse_swar, false },
+        { "simd", parse_simd, false },
+    };
+
+    struct BufKernel { const char* name; ParseBufFunc func; bool takes_signs; };
+    std::vector<BufKernel> buf_kernels = {
+        { "stringstream buffer", parse_string_stream_buf, true },
+        { "sscanf buffer", parse_sscanf_buf, true },
+        { "strtoull buffer", parse_strtoull_buf, true },
+        { "from_chars buffer", parse_from_chars_buf, false },
+        { "custom buffer", parse_custom_buf, false },
+        { "swar buffer", parse_swar_buf, false },
+        { "custom skip buffer", parse_custom_skip_buf, false },
+        { "swar skip buffer", parse_swar_skip_buf, false },
+        { "simd buffer", parse_simd_buf, false },
+        { "fields<uint64_t, 2>", parse_typed_buf<uint64_t>, false },
+    };
+#ifdef HAVE_X86_SIMD
+    if (cpu_has_sse42()) {
+        buf_kernels.push_back({ "sse4.2 buffer", parse_sse42_buf, false });
+    }
+    if (cpu_has_avx2()) {
+        buf_kernels.push_back({ "avx2 buffer", parse_avx2_buf, false });
+    }
+#endif
+
+    size_t kernels = 0;
+    for (const auto& kernel : string_kernels) {
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (kernel.takes_signs && has_sign(lines[i])) {
+                continue;
+            }
+            Result actual = kernel.func(lines[i]);
+            if (actual != expected[i]) {
+                diffs.add(kernel.name, lines[i], actual, expected[i]);
+            }
+        }
+        ++kernels;
+    }
+
+    const char* end = buffer.data() + buffer.size();
+    for (const auto& kernel : buf_kernels) {
+        const char* p = buffer.data();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            Result actual = kernel.func(p, end, p);
+            if (!(kernel.takes_signs && has_sign(lines[i])) && actual != expected[i]) {
+                diffs.add(kernel.name, lines[i], actual, expected[i]);
+            }
+        }
+        if (p != end) {
+            diffs.add(std::string(kernel.name) + " (did not end with the buffer)", "", {}, {});
+        }
+        ++kernels;
+    }
+
+    // same as from_chars, except that anything above 2^32 - 1 does not fit
+    const char* p = buffer.data();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        Result actual = parse_typed_buf<uint32_t>(p, end, p);
+        Result wanted = expected[i];
+        if (wanted.err == ErrCode::success && std::max(wanted.row, wanted.col) > UINT32_MAX) {
+            wanted.err = ErrCode::error;
+        }
+        if (actual != wanted) {
+            diffs.add("fields<uint32_t, 2>", lines[i], actual, wanted);
+        }
+    }
+    ++kernels;
+
+    check_batches<parse_custom_buf>("custom batch", buffer, lines, expected, diffs);
+    check_batches<parse_simd_buf>("simd batch", buffer, lines, expected, diffs);
+    return kernels + 2;
+}
+
+void test_differential() {
+    std::vector<std::string> lines(20'000);
+    for (auto& line : lines) {
+        line = random_line();
+    }
+
+    Differences diffs;
+    run_differential(lines, diffs);
+    if (diffs.count == 0) {
+        std::cerr << "TEST PASSED: differential\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                STAGE STATISTICS                                //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// With several stages in a loader a single time per line does not tell which one got slower. Built with
+// BENCH_STAGE_STATS (a cmake option), the stages time themselves and count what went through them, per
+// thread, and the totals of the whole run are printed at the end. The counting happens once per chunk or
+// buffer, never per line. Without it all the macros below expand to nothing.
+
+#ifdef BENCH_STAGE_STATS
+
+enum class Stage {
+    read,
+    decompress,
+    split,
+    parse,
+    merge,
+    csr,
+    count
+};
+
+const char* const stage_names[] = { "read", "decompress", "split", "parse", "merge", "csr" };
+
+// Relaxed atomics, so two threads which happen to share a slot don't race.
+struct StageCounters {
+    std::atomic<uint64_t> calls{ 0 };
+    std::atomic<uint64_t> nanoseconds{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> lines{ 0 };
+    std::atomic<uint64_t> empty{ 0 };
+    std::atomic<uint64_t> errors{ 0 };
+};
+
+// The loaders number their threads from 0, the slot is picked by that number.
+constexpr size_t max_stage_threads = 64;
+StageCounters stage_counters[max_stage_threads][static_cast<size_t>(Stage::count)];
+thread_local size_t stage_thread = 0;
+
+StageCounters& stage_counter(Stage stage) {
+    return stage_counters[stage_thread % max_stage_threads][static_cast<size_t>(stage)];
+}
+
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~StageTimer() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+        StageCounters& counter = stage_counter(stage_);
+        counter.calls.fetch_add(1, std::memory_order_relaxed);
+        counter.nanoseconds.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+void count_stage_lines(Stage stage, uint64_t lines, uint64_t empty, uint64_t errors) {
+    StageCounters& counter = stage_counter(stage);
+    counter.lines.fetch_add(lines, std::memory_order_relaxed);
+    counter.empty.fetch_add(empty, std::memory_order_relaxed);
+    counter.errors.fetch_add(errors, std::memory_order_relaxed);
+}
+
+#define STAGE_CONCAT_IMPL(a, b) a##b
+#define STAGE_CONCAT(a, b) STAGE_CONCAT_IMPL(a, b)
+
+// times the rest of the enclosing scope
+#define STAGE_TIMER(stage) StageTimer STAGE_CONCAT(stage_timer_, __LINE__)(Stage::stage)
+#define STAGE_BYTES(stage, n) stage_counter(Stage::stage).bytes.fetch_add((n), std::memory_order_relaxed)
+#define STAGE_LINES(stage, lines, empty, errors) count_stage_lines(Stage::stage, (lines), (empty), (errors))
+#define STAGE_THREAD(t) (stage_thread = (t))
+
+// Calls a function with every slot that was used, benchmarks and tests together.
+template<typename Func>
+void for_each_stage_counter(Func func) {
+    for (size_t stage = 0; stage < static_cast<size_t>(Stage::count); ++stage) {
+        for (size_t t = 0; t < max_stage_threads; ++t) {
+            const StageCounters& counter = stage_counters[t][stage];
+            if (counter.calls.load(std::memory_order_relaxed) > 0) {
+                func(stage_names[stage], t, counter);
+            }
+        }
+    }
+}
+
+// Runs with nanobench's many iterations add up, so the totals are mostly good for the ratios between the
+// stages and the threads.
+void print_stage_stats() {
+    std::cout << "\n| stages of the whole run\n";
+    std::cout << "| stage      | thread |      calls |       total ms |        ms/call |         MB |      lines |      empty |     errors\n";
+    std::cout << "|:-----------|-------:|-----------:|---------------:|---------------:|-----------:|-----------:|-----------:|----------:\n";
+    for_each_stage_counter([] (const char* name, size_t t, const StageCounters& counter) {
+        uint64_t calls = counter.calls.load(std::memory_order_relaxed);
+        double ms = counter.nanoseconds.load(std::memory_order_relaxed)*1e-6;
+        char row[256];
+        snprintf(row, sizeof(row), "| %-10s | %6zu | %10llu | %14.3f | %14.6f | %10.2f | %10llu | %10llu | %10llu\n", name, 
+                 t, static_cast<unsigned long long>(calls), ms, ms/calls, counter.bytes.load(std::memory_order_relaxed)*1e-6,
+                 static_cast<unsigned long long>(counter.lines.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long long>(counter.empty.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long long>(counter.errors.load(std::memory_order_relaxed)));
+        std::cout << row;
+    });
+}
+
+// The same in the format of the csv export.
+bool write_stage_stats(const std::string& path) {
+    std::ofstream out(path);
+    out << "\"stage\";\"thread\";\"calls\";\"nanoseconds\";\"bytes\";\"lines\";\"empty\";\"errors\"\n";
+    for_each_stage_counter([&] (const char* name, size_t t, const StageCounters& counter) {
+        out << "\"" << name << "\";" << t << ";" << counter.calls << ";" << counter.nanoseconds << ";" << counter.bytes 
+            << ";" << counter.lines << ";" << counter.empty << ";" << counter.errors << "\n";
+    });
+    return static_cast<bool>(out);
+}
+
+#else
+
+#define STAGE_TIMER(stage) static_cast<void>(0)
+#define STAGE_BYTES(stage, n) static_cast<void>(0)
+#define STAGE_LINES(stage, lines, empty, errors) static_cast<void>(0)
+#define STAGE_THREAD(t) static_cast<void>(0)
+
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                FILE LOADING                                    //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// Generates a matrix market file resembling the ones from my side-project.
+// The indices have varied widths, the separators are not always a single space,
+// there is a trailing float on every line and here and there is a blank line.
+// With `bad_every` set, one in about that many entries is broken in some way.
+void generate_matrix_file(const std::string& path, size_t entries, size_t bad_every = 0) {
+    constexpr size_t max_width = 7;
+    constexpr size_t dim = 9'999'999;
+
+    std::uniform_int_distribution<size_t> width_dist(1, max_width);
+    std::uniform_int_distribution<int> percent_dist(0, 99);
+    std::uniform_int_distribution<int> precision_dist(1, 17);
+    std::uniform_real_distribution<double> value_dist(-1000.0, 1000.0);
+
+    auto random_index = [&] () {
+        size_t width = width_dist(mt);
+        size_t lo = 1;
+        for (size_t i = 1; i < width; ++i) {
+            lo *= 10;
+        }
+        return std::uniform_int_distribution<size_t>(lo, 10*lo - 1)(mt);
+    };
+
+    auto random_separator = [&] () -> const char* {
+        int p = percent_dist(mt);
+        if (p < 90) return " ";
+        if (p < 95) return "\t";
+        return "   ";
+    };
+
+    std::ofstream out(path, std::ios::binary);
+
+    out << "%%MatrixMarket matrix coordinate real general\n";
+    out << "% generated by the integer parsing benchmark\n";
+    out << dim << " " << dim << " " << entries << "\n";
+
+    char value[64];
+    for (size_t i = 0; i < entries; ++i) {
+        if (percent_dist(mt) == 0) {
+            out << (percent_dist(mt) < 50 ? "\n" : "  \t \n");
+        }
+
+        snprintf(value, sizeof(value), "%.*g", precision_dist(mt), value_dist(mt));
+        if (bad_every > 0 && std::uniform_int_distribution<size_t>(0, bad_every - 1)(mt) == 0) {
+            static const char* const bad_lines[] = { "12 x 1.0", "-3 4 1.0", "99999999999999999999 1 1.0", "7", "5 \t " };
+            out << bad_lines[std::uniform_int_distribution<size_t>(0, std::size(bad_lines) - 1)(mt)] << "\n";
+            continue;
+        }
+        out << random_index() << random_separator() << random_index() << random_separator() << value;
+
+        if (percent_dist(mt) < 5) {
+            out << " ";
+        }
+        out << "\n";
+    }
+}
+
+// A file where equally sized chunks take very different amounts of time. Most of the lines have short
+// indices, but a region a quarter into the file has 19 and 20 digit indices with long runs of
+// whitespace, which no fast path likes.
+void generate_skewed_file(const std::string& path, size_t entries) {
+    std::uniform_int_distribution<uint64_t> short_dist(1, 999);
+    std::uniform_int_distribution<uint64_t> long_dist(1'000'000'000'000'000'000ull, 18'446'744'073'709'551'615ull);
+
+    std::ofstream out(path, std::ios::binary);
+
+    out << "%%MatrixMarket matrix coordinate real general\n";
+    out << uint64_t(-1) << " " << uint64_t(-1) << " " << entries << "\n";
+
+    for (size_t i = 0; i < entries; ++i) {
+        if (i >= entries/4 && i < entries*3/8) {
+            out << long_dist(mt) << "    \t     " << long_dist(mt) << "    \t     1.0\n";
+        } else {
+            out << short_dist(mt) << " " << short_dist(mt) << " 1.0\n";
+        }
+    }
+}
+
+struct LoadStats {
+    size_t entries = 0;
+    size_t empty = 0;
+    size_t errors = 0;
+    // sum of all the indices, so that the contenders can be checked against each other
+    size_t checksum = 0;
+};
+
+bool operator==(const LoadStats& a, const LoadStats& b) {
+    return a.entries == b.entries && a.empty == b.empty && a.errors == b.errors && a.checksum == b.checksum;
+}
+
+std::ostream& operator<<(std::ostream& out, const LoadStats& stats) {
+    return out << stats.entries << " entries, " << stats.empty << " empty, " 
+               << stats.errors << " errors, checksum " << stats.checksum;
+}
+
+void add_result(LoadStats& stats, Result res) {
+    switch (res.err) {
+        case ErrCode::success:
+            ++stats.entries;
+            stats.checksum += res.row + res.col;
+            break;
+        case ErrCode::empty:
+            ++stats.empty;
+            break;
+        case ErrCode::error:
+            ++stats.errors;
+            break;
+    }
+}
+
+// Reads the file line by line, the way my side-project does it.
+// The comments and the size line at the top are skipped, they are not what we care about here.
+template<typename Func>
+LoadStats load_file(const std::string& path, Func func) {
+    LoadStats stats;
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+
+    // the loop stops on the first line that is not a comment, which is the size line
+    while (std::getline(in, line) && !line.empty() && line[0] == '%') { }
+
+    while (std::getline(in, line)) {
+        add_result(stats, func(line));
+    }
+
+    return stats;
+}
+
+// Skips the comments and the size line at the beginning of a buffer.
+const char* skip_header(const char* begin, const char* end) {
+    const char* p = begin;
+    while (p < end && *p == '%') {
+        p = next_line(find_line_end(p, end), end);
+    }
+    return next_line(find_line_end(p, end), end);
+}
+
+// Walks all the lines in the buffer (except the header) with a buffer based implementation.
+template<typename BufFunc>
+LoadStats parse_buffer(const char* begin, const char* end, BufFunc func) {
+    STAGE_TIMER(parse);
+    LoadStats stats;
+    const char* p = skip_header(begin, end);
+    while (p < end) {
+        add_result(stats, func(p, end, p));
+    }
+    STAGE_BYTES(parse, end - begin);
+    STAGE_LINES(parse, stats.entries + stats.empty + stats.errors, stats.empty, stats.errors);
+    return stats;
+}
+
+// Same as parse_buffer, but with the values parsed too. They are summed up into `value_sum`.
+LoadStats parse_buffer_values(const char* begin, const char* end, double& value_sum) {
+    LoadStats stats;
+    value_sum = 0;
+    const char* p = skip_header(begin, end);
+    while (p < end) {
+        double value = 0;
+        Result res = parse_value_buf(p, end, p, value);
+        add_result(stats, res);
+        value_sum += res.err == ErrCode::success ? value : 0;
+    }
+    return stats;
+}
+
+// parse_buffer on top of the batch interface. The lines which failed only need to be looked at
+// if there are any, and the checksum needs no checks at all since their slots are zero.
+template<ParseBufFunc parse_line>
+LoadStats parse_buffer_batched(const char* begin, const char* end) {
+    constexpr size_t batch_size = 256;
+
+    LoadStats stats;
+    LineBatch<batch_size> batch;
+    const char* p = skip_header(begin, end);
+    while (p < end) {
+        size_t count = parse_batch_buf<batch_size, parse_line>(p, end, p, batch);
+
+        size_t failed = 0;
+        if (!batch.all_success()) {
+            for (size_t i = 0; i < batch_size/64; ++i) {
+                stats.empty += popcount(batch.empty[i]);
+                stats.errors += popcount(batch.errors[i]);
+                failed += popcount(batch.empty[i] | batch.errors[i]);
+            }
+        }
+        stats.entries += count - failed;
+
+        for (size_t i = 0; i < count; ++i) {
+            stats.checksum += batch.rows[i] + batch.cols[i];
+        }
+    }
+    return stats;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream sstream;
+    sstream << in.rdbuf();
+    return sstream.str();
+}
+
+struct FileInfo {
+    size_t bytes = 0;
+    size_t lines = 0;
+};
+
+FileInfo get_file_info(const std::string& path) {
+    FileInfo info;
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        info.bytes += line.size() + 1;
+        ++info.lines;
+    }
+    return info;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                FILE READING                                    //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) {
+            return;
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        
+        // mapping an empty file fails, but there is nothing to map anyway
+        if (size_ == 0) {
+            ok_ = true;
+            return;
+        }
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            return;
+        }
+
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        ok_ = data_ != nullptr;
+#else
+        fd_ = open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            return;
+        }
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            return;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        // mapping an empty file fails, but there is nothing to map anyway
+        if (size_ == 0) {
+            ok_ = true;
+            return;
+        }
+
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (addr == MAP_FAILED) {
+            return;
+        }
+        // we are going to read it from start to end exactly once
+        madvise(addr, size_, MADV_SEQUENTIAL);
+
+        data_ = static_cast<const char*>(addr);
+        ok_ = true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if (data_) munmap(const_cast<char*>(data_), size_);
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return ok_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+private:
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool ok_ = false;
+};
+
+// Reads the whole file with a single fread into a buffer of the right size.
+std::vector<char> fread_file(const std::string& path) {
+    STAGE_TIMER(read);
+    std::vector<char> buffer;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return buffer;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (size > 0) {
+        buffer.resize(static_cast<size_t>(size));
+        buffer.resize(fread(buffer.data(), 1, buffer.size(), file));
+    }
+    STAGE_BYTES(read, buffer.size());
+
+    fclose(file);
+    return buffer;
+}
+
+LoadStats load_file_fread(const std::string& path) {
+    std::vector<char> buffer = fread_file(path);
+    return parse_buffer(buffer.data(), buffer.data() + buffer.size(), parse_custom_buf);
+}
+
+LoadStats load_file_mmap(const std::string& path) {
+    MappedFile file(path);
+    if (!file.ok()) {
+        return {};
+    }
+    return parse_buffer(file.begin(), file.end(), parse_custom_buf);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                MULTI-THREADED LOADING                          //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// Entries as they end up in memory after loading a file.
+struct Entry {
+    size_t row;
+    size_t col;
+};
+
+struct ParsedFile {
+    std::vector<Entry> entries;
+    LoadStats stats;
+};
+
+void merge_stats(LoadStats& into, const LoadStats& from) {
+    into.entries += from.entries;
+    into.empty += from.empty;
+    into.errors += from.errors;
+    into.checksum += from.checksum;
+}
+
+// Splits the buffer into `n` roughly equal chunks, every boundary is moved to the beginning of the next line.
+// Returns the `n + 1` boundaries, some chunks may be empty if the lines are really long.
+std::vector<const char*> split_lines(const char* begin, const char* end, size_t n) {
+    STAGE_TIMER(split);
+    std::vector<const char*> bounds(n + 1);
+    size_t size = end - begin;
+
+    bounds[0] = begin;
+    for (size_t i = 1; i < n; ++i) {
+        const char* p = begin + size*i/n;
+        // the previous chunk might have already been moved past this one
+        if (p < bounds[i - 1]) {
+            p = bounds[i - 1];
+        }
+        // a chunk boundary right after a newline already is at the beginning of a line
+        bounds[i] = (p == begin || p[-1] == '\n') ? p : next_line(find_line_end(p, end), end);
+    }
+    bounds[n] = end;
+
+    return bounds;
+}
+
+template<typename BufFunc>
+void parse_chunk(const char* begin, const char* end, BufFunc func, ParsedFile& out) {
+    STAGE_TIMER(parse);
+    LoadStats stats;
+    const char* p = begin;
+    while (p < end) {
+        Result res = func(p, end, p);
+        add_result(stats, res);
+        if (res.err == ErrCode::success) {
+            out.entries.push_back({ res.row, res.col });
+        }
+    }
+    STAGE_BYTES(parse, end - begin);
+    STAGE_LINES(parse, stats.entries + stats.empty + stats.errors, stats.empty, stats.errors);
+    merge_stats(out.stats, stats);
+}
+
+// Concatenates the parts in their order into a single result. Copying all the entries is not 
+// negligible, so it is done by `n_threads` threads too.
+ParsedFile merge_parts(const std::vector<ParsedFile>& parts, size_t n_threads) {
+    ParsedFile result;
+    std::vector<size_t> offsets(parts.size() + 1, 0);
+    for (size_t i = 0; i < parts.size(); ++i) {
+        merge_stats(result.stats, parts[i].stats);
+        offsets[i + 1] = offsets[i] + parts[i].entries.size();
+    }
+
+    result.entries.resize(offsets[parts.size()]);
+    auto copy_parts = [&] (size_t t) {
+        STAGE_THREAD(t);
+        STAGE_TIMER(merge);
+        for (size_t i = t; i < parts.size(); i += n_threads) {
+            STAGE_BYTES(merge, parts[i].entries.size()*sizeof(Entry));
+            std::copy(parts[i].entries.begin(), parts[i].entries.end(), result.entries.begin() + offsets[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < n_threads; ++t) {
+        threads.emplace_back(copy_parts, t);
+    }
+    copy_parts(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    return result;
+}
+
+// Parses the whole buffer with `n_threads` threads, each of them getting one chunk, into one part per
+// thread. If `busy` is given, it gets how many seconds each of the threads spent parsing.
+template<typename BufFunc>
+std::vector<ParsedFile> parse_parallel_parts(const char* begin, const char* end, size_t n_threads, BufFunc func, 
+                                             std::vector<double>* busy = nullptr) {
+    begin = skip_header(begin, end);
+    std::vector<const char*> bounds = split_lines(begin, end, n_threads);
+    std::vector<ParsedFile> parts(n_threads);
+    std::vector<double> seconds(n_threads);
+
+    auto parse_part = [&] (size_t i) {
+        STAGE_THREAD(i);
+        auto start = std::chrono::steady_clock::now();
+        parse_chunk(bounds[i], bounds[i + 1], func, parts[i]);
+        seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // the calling thread takes the first chunk so there is no thread to spawn for a single one
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n_threads; ++i) {
+        threads.emplace_back(parse_part, i);
+    }
+    parse_part(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    if (busy) {
+        *busy = seconds;
+    }
+    return parts;
+}
+
+// The same with the parts merged, so the entries end up in the same order as in the file.
+template<typename BufFunc>
+ParsedFile parse_parallel(const char* begin, const char* end, size_t n_threads, BufFunc func, 
+                          std::vector<double>* busy = nullptr) {
+    return merge_parts(parse_parallel_parts(begin, end, n_threads, func, busy), n_threads);
+}
+
+// With equally sized chunks the slowest one decides how long everything takes, and on real files some
+// parts are a lot slower than others (long indices, lots of whitespace). So here the buffer is split into
+// many small tasks instead. Every thread starts with an equal share of them, takes them from the front
+// and when it runs out it steals the last task of whichever thread has the most left.
+template<typename BufFunc>
+ParsedFile parse_work_stealing(const char* begin, const char* end, size_t n_threads, BufFunc func, 
+                               size_t task_size = 64 << 10, std::vector<double>* busy = nullptr) {
+    // the tasks of a thread are [next, last), the owner takes from the front and thieves from the back
+    struct Queue {
+        std::mutex mutex;
+        size_t next = 0;
+        size_t last = 0;
+    };
+
+    begin = skip_header(begin, end);
+    task_size = std::max<size_t>(task_size, 1);
+    size_t n_tasks = std::max<size_t>(n_threads, (end - begin + task_size - 1) / task_size);
+    std::vector<const char*> bounds = split_lines(begin, end, n_tasks);
+    std::vector<ParsedFile> parts(n_tasks);
+    std::vector<double> seconds(n_threads);
+
+    std::vector<Queue> queues(n_threads);
+    for (size_t t = 0; t < n_threads; ++t) {
+        queues[t].next = n_tasks*t/n_threads;
+        queues[t].last = n_tasks*(t + 1)/n_threads;
+    }
+
+    auto take_own = [&] (size_t t, size_t& task) {
+        std::lock_guard<std::mutex> lock(queues[t].mutex);
+        if (queues[t].next == queues[t].last) {
+            return false;
+        }
+        task = queues[t].next++;
+        return true;
+    };
+
+    // the queue picked as the victim might be empty again once it is locked the second time, then just look again
+    auto steal = [&] (size_t t, size_t& task) {
+        while (true) {
+            size_t victim = t;
+            size_t most = 0;
+            for (size_t v = 0; v < n_threads; ++v) {
+                std::lock_guard<std::mutex> lock(queues[v].mutex);
+                size_t left = queues[v].last - queues[v].next;
+                if (left > most) {
+                    most = left;
+                    victim = v;
+                }
+            }
+            if (most == 0) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(queues[victim].mutex);
+            if (queues[victim].next < queues[victim].last) {
+                task = --queues[victim].last;
+                return true;
+            }
+        }
+    };
+
+    auto worker = [&] (size_t t) {
+        STAGE_THREAD(t);
+        auto start = std::chrono::steady_clock::now();
+        size_t task;
+        while (take_own(t, task) || steal(t, task)) {
+            parse_chunk(bounds[task], bounds[task + 1], func, parts[task]);
+        }
+        seconds[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < n_threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    if (busy) {
+        *busy = seconds;
+    }
+    return merge_parts(parts, n_threads);
+}
+
+
+// Bounded lock-free queue handing values from any number of producers to a single consumer, after
+// Dmitry Vyukov's bounded MPMC queue. Every slot has a sequence number saying whether it is free for
+// the push of the current round or holds the value for its pop, so the producers only contend on
+// `tail_` and the consumer on nothing at all. With a single producer it is a plain SPSC ring.
+template<typename T>
+class BoundedQueue {
+public:
+    // The capacity is rounded up to a power of two, at least 2. With a single slot the sequence number
+    // of a full slot would be the same as the one saying it is free for the next push.
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        slots_ = std::make_unique<Slot[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Moves `value` into the queue, returns false without touching it if the queue is full.
+    bool try_push(T& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the consumer has not taken the value of the previous round out of the slot yet
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = std::move(value);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only ever to be called from one thread at a time. Returns false if the queue is empty.
+    bool try_pop(T& value) {
+        Slot& slot = slots_[head_ & mask_];
+        if (slot.seq.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+
+        value = std::move(slot.value);
+        slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    // on separate cache lines, the producers hammer on the tail
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    alignas(64) size_t head_ = 0;
+};
+
+// The entries travel through the queue in fixed batches, so there is no allocation per batch. Copying
+// a batch in and out costs about as much as parsing a couple of its lines.
+struct EntryBatch {
+    static constexpr size_t capacity = 1024;
+
+    size_t count = 0;
+    std::array<Entry, capacity> entries;
+};
+
+// Like parse_parallel(), but the entries are not collected. `n_producers` threads parse a chunk each and
+// push the entries in batches into a queue of `queue_size` batches, which the calling thread drains into
+// `consume(const Entry*, size_t)` while the parsing is still going on. So the consumer can start right
+// after the first batch instead of after the whole file. The batches of the chunks arrive interleaved,
+// only the order within every chunk is kept.
+template<typename BufFunc, typename Consumer>
+LoadStats parse_parallel_queued(const char* begin, const char* end, size_t n_producers, BufFunc func, 
+                                Consumer&& consume, size_t queue_size = 64) {
+    begin = skip_header(begin, end);
+    std::vector<const char*> bounds = split_lines(begin, end, n_producers);
+    std::vector<LoadStats> stats(n_producers);
+    BoundedQueue<EntryBatch> queue(queue_size);
+    std::atomic<size_t> producers_done{ 0 };
+
+    // a full queue means the consumer is behind, giving it the core is the best we can do
+    auto push = [&] (EntryBatch& batch) {
+        while (!queue.try_push(batch)) {
+            std::this_thread::yield();
+        }
+        batch.count = 0;
+    };
+
+    // the time of the parse stage includes waiting for a full queue
+    auto produce = [&] (size_t i) {
+        STAGE_THREAD(i);
+        STAGE_TIMER(parse);
+        auto batch = std::make_unique<EntryBatch>();
+        const char* p = bounds[i];
+        while (p < bounds[i + 1]) {
+            Result res = func(p, bounds[i + 1], p);
+            add_result(stats[i], res);
+            if (res.err == ErrCode::success) {
+                batch->entries[batch->count++] = { res.row, res.col };
+                if (batch->count == EntryBatch::capacity) {
+                    push(*batch);
+                }
+            }
+        }
+        if (batch->count > 0) {
+            push(*batch);
+        }
+        STAGE_BYTES(parse, bounds[i + 1] - bounds[i]);
+        STAGE_LINES(parse, stats[i].entries + stats[i].empty + stats[i].errors, stats[i].empty, stats[i].errors);
+        producers_done.fetch_add(1, std::memory_order_release);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n_producers; ++i) {
+        threads.emplace_back(produce, i);
+    }
+
+    // everything a producer pushed is visible once its increment of producers_done is, so the queue
+    // has to be checked once more after the last one finished
+    auto batch = std::make_unique<EntryBatch>();
+    while (true) {
+        if (queue.try_pop(*batch)) {
+            consume(batch->entries.data(), batch->count);
+        } else if (producers_done.load(std::memory_order_acquire) == n_producers) {
+            if (!queue.try_pop(*batch)) {
+                break;
+            }
+            consume(batch->entries.data(), batch->count);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    LoadStats result;
+    for (const auto& s : stats) {
+        merge_stats(result, s);
+    }
+    return result;
+}
+
+
+#ifdef HAVE_NUMA
+
+// The numa nodes which have cpus, some only have memory. Empty if the kernel does not support numa.
+std::vector<int> numa_cpu_nodes() {
+    std::vector<int> nodes;
+    if (numa_available() < 0) {
+        return nodes;
+    }
+
+    struct bitmask* cpus = numa_allocate_cpumask();
+    for (int node = 0; node <= numa_max_node(); ++node) {
+        if (numa_node_to_cpus(node, cpus) == 0 && numa_bitmask_weight(cpus) > 0) {
+            nodes.push_back(node);
+        }
+    }
+    numa_free_cpumask(cpus);
+    return nodes;
+}
+
+// parse_parallel_parts() leaves it to the scheduler where the threads run, so a thread can parse a chunk
+// which sits in the memory of the other socket, or move there after its output was allocated. Here the
+// consecutive chunks are spread over `nodes` and every thread is bound to the cpus of its node before it
+// touches anything, so its part gets allocated and first touched in the memory of that node. The pages
+// of the mapped file stay wherever the page cache put them, with `copy_input` every thread first copies
+// its chunk into memory of its own node and parses that. All the threads are started anew, so the 
+// calling thread is not bound to anything afterwards.
+template<typename BufFunc>
+std::vector<ParsedFile> parse_parallel_numa(const char* begin, const char* end, size_t n_threads, BufFunc func,
+                                            const std::vector<int>& nodes, bool copy_input) {
+    begin = skip_header(begin, end);
+    std::vector<const char*> bounds = split_lines(begin, end, n_threads);
+    std::vector<ParsedFile> parts(n_threads);
+
+    auto parse_part = [&] (size_t i) {
+        numa_run_on_node(nodes[i*nodes.size()/n_threads]);
+        numa_set_localalloc();
+
+        size_t size = bounds[i + 1] - bounds[i];
+        if (!copy_input || size == 0) {
+            parse_chunk(bounds[i], bounds[i + 1], func, parts[i]);
+            return;
+        }
+
+        char* local = static_cast<char*>(numa_alloc_local(size));
+        if (!local) {
+            parse_chunk(bounds[i], bounds[i + 1], func, parts[i]);
+            return;
+        }
+        std::memcpy(local, bounds[i], size);
+        parse_chunk(local, local + size, func, parts[i]);
+        numa_free(local, size);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n_threads; ++i) {
+        threads.emplace_back(parse_part, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    return parts;
+}
+
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                STREAMING                                       //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// Plain unbuffered reads, the buffering is done by the stream parser itself.
+class InputFile {
+public:
+    explicit InputFile(const std::string& path) {
+#ifdef _WIN32
+        fd_ = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+        fd_ = open(path.c_str(), O_RDONLY);
+#endif
+    }
+
+    ~InputFile() {
+        if (fd_ >= 0) {
+#ifdef _WIN32
+            _close(fd_);
+#else
+            close(fd_);
+#endif
+        }
+    }
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+
+    // Returns the number of bytes read, 0 at the end of the file and -1 on error.
+    long long read(char* dst, size_t size) {
+        STAGE_TIMER(read);
+#ifdef _WIN32
+        long long n = _read(fd_, dst, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+        ssize_t n;
+        do {
+            n = ::read(fd_, dst, size);
+        } while (n < 0 && errno == EINTR);
+#endif
+        STAGE_BYTES(read, n > 0 ? n : 0);
+        return n;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+// The end of the last complete line in the buffer, `begin` if there is none.
+const char* last_line_end(const char* begin, const char* end) {
+    for (const char* p = end; p > begin; --p) {
+        if (p[-1] == '\n') {
+            return p;
+        }
+    }
+    return begin;
+}
+
+// The part of the streaming loaders which does not care where the data comes from. Gets the file
+// piece by piece, every piece consisting of complete lines only, skips the header and hands the
+// entries to `sink(const Entry*, size_t)` in batches of at most `batch_size`.
+template<typename BufFunc, typename Sink>
+class StreamParser {
+public:
+    static constexpr size_t batch_size = 4096;
+
+    StreamParser(BufFunc func, Sink& sink, LoadStats& stats) : func_(func), sink_(sink), stats_(stats) {
+        batch_.reserve(batch_size);
+    }
+
+    void parse(const char* begin, const char* end) {
+        const char* p = begin;
+        while (in_header_ && p < end) {
+            in_header_ = *p == '%';
+            p = next_line(find_line_end(p, end), end);
+        }
+        while (p < end) {
+            Result res = func_(p, end, p);
+            add_result(stats_, res);
+            if (res.err == ErrCode::success) {
+                batch_.push_back({ res.row, res.col });
+                if (batch_.size() == batch_size) {
+                    sink_(batch_.data(), batch_.size());
+                    batch_.clear();
+                }
+            }
+        }
+    }
+
+    void finish() {
+        if (!batch_.empty()) {
+            sink_(batch_.data(), batch_.size());
+            batch_.clear();
+        }
+    }
+
+private:
+    BufFunc func_;
+    Sink& sink_;
+    LoadStats& stats_;
+    std::vector<Entry> batch_;
+    bool in_header_ = true;
+};
+
+// Parses the file through a buffer of `buffer_size` bytes, so the memory needed does not depend on the
+// size of the file. Only the complete lines in the buffer are parsed, the incomplete one at the end gets
+// moved to the front before the next refill. Fails if the file can't be read or a line does not fit into 
+// the buffer.
+template<typename BufFunc, typename Sink>
+bool stream_file(const std::string& path, size_t buffer_size, BufFunc func, Sink&& sink, LoadStats& stats) {
+    InputFile file(path);
+    if (!file.ok() || buffer_size == 0) {
+        return false;
+    }
+
+    StreamParser<BufFunc, Sink> parser(func, sink, stats);
+    std::vector<char> buffer(buffer_size);
+    size_t filled = 0;
+    bool eof = false;
+
+    while (!eof) {
+        long long n = file.read(buffer.data() + filled, buffer_size - filled);
+        if (n < 0) {
+            return false;
+        }
+        filled += static_cast<size_t>(n);
+        eof = n == 0;
+
+        // the last line does not need a newline
+        const char* begin = buffer.data();
+        const char* end = eof ? begin + filled : last_line_end(begin, begin + filled);
+        if (end == begin && filled == buffer_size) {
+            return false;
+        }
+
+        parser.parse(begin, end);
+
+        filled -= end - begin;
+        memmove(buffer.data(), end, filled);
+    }
+
+    parser.finish();
+    return true;
+}
+
+// Like stream_file(), but the reading happens on a separate thread. While the parser works on one of 
+// the `n_buffers` buffers the thread fills the next one, so the disk and the cpu are busy at the same
+// time instead of taking turns. With two buffers this is plain double buffering.
+template<typename BufFunc, typename Sink>
+bool stream_file_pipelined(const std::string& path, size_t buffer_size, size_t n_buffers, 
+                           BufFunc func, Sink&& sink, LoadStats& stats) {
+    struct Slot {
+        std::vector<char> data;
+        // only the complete lines at the beginning of `data` are handed to the parser
+        size_t size = 0;
+        bool full = false;
+        bool last = false;
+    };
+
+    InputFile file(path);
+    if (!file.ok() || buffer_size == 0 || n_buffers < 2) {
+        return false;
+    }
+
+    std::vector<Slot> slots(n_buffers);
+    for (auto& slot : slots) {
+        slot.data.resize(buffer_size);
+    }
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool failed = false;
+
+    std::thread reader([&] {
+        // the incomplete line at the end of the previous buffer, the parser never looks at it
+        const char* tail = nullptr;
+        size_t tail_size = 0;
+
+        for (size_t i = 0; ; ++i) {
+            Slot& slot = slots[i % n_buffers];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&] { return !slot.full; });
+            }
+
+            char* data = slot.data.data();
+            memcpy(data, tail, tail_size);
+            size_t filled = tail_size;
+            bool eof = false;
+            bool error = false;
+            while (filled < buffer_size) {
+                long long n = file.read(data + filled, buffer_size - filled);
+                if (n <= 0) {
+                    eof = n == 0;
+                    error = n < 0;
+                    break;
+                }
+                filled += static_cast<size_t>(n);
+            }
+
+            // the last line does not need a newline
+            size_t size = eof ? filled : last_line_end(data, data + filled) - data;
+            error = error || (!eof && size == 0);
+            tail = data + size;
+            tail_size = filled - size;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = error;
+                slot.size = size;
+                slot.full = true;
+                slot.last = eof || error;
+            }
+            cond.notify_all();
+            if (eof || error) {
+                return;
+            }
+        }
+    });
+
+    StreamParser<BufFunc, Sink> parser(func, sink, stats);
+    for (size_t i = 0; ; ++i) {
+        Slot& slot = slots[i % n_buffers];
+        bool abort;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [&] { return slot.full; });
+            abort = slot.last && failed;
+        }
+        if (abort) {
+            break;
+        }
+
+        parser.parse(slot.data.data(), slot.data.data() + slot.size);
+
+        bool last = slot.last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.full = false;
+        }
+        cond.notify_all();
+        if (last) {
+            break;
+        }
+    }
+
+    reader.join();
+    parser.finish();
+    return !failed;
+}
+
+// So that the next read of the file has to go to the disk. Only possible on linux, where the kernel
+// drops the clean pages of the file when asked, returns false anywhere else.
+bool evict_page_cache(const std::string& path) {
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // a freshly generated file is still dirty and dirty pages can't be dropped
+    fsync(fd);
+    int res = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return res == 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// The highest resident set size of the process since the last reset_peak_rss(), in bytes.
+// Only available on linux, returns 0 anywhere else.
+size_t peak_rss() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+#endif
+    return 0;
+}
+
+void reset_peak_rss() {
+#ifdef __linux__
+    // see "man 5 proc", writing 5 resets the peak to the current resident set size
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                STRUCTURE OF ARRAYS OUTPUT                      //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// `Result` is 24 bytes per entry thanks to the padding after `err`, and once a line parsed
+// successfully the error code is useless anyway. So for bulk loading the rows and columns go
+// into separate arrays and the few lines which failed are reported on the side.
+
+struct LineError {
+    // counted from 1 including the header, like in any text editor
+    size_t line;
+    ErrCode err;
+};
+
+// The allocator is there so the arrays can live in an Arena, see below.
+template<typename Index, typename Alloc = std::allocator<Index>>
+struct IndexArrays {
+    using ErrorAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<LineError>;
+
+    explicit IndexArrays(const Alloc& alloc = Alloc()) : rows(alloc), cols(alloc), errors(ErrorAlloc(alloc)) {}
+
+    std::vector<Index, Alloc> rows;
+    std::vector<Index, Alloc> cols;
+    std::vector<LineError, ErrorAlloc> errors;
+    size_t empty = 0;
+
+    size_t bytes() const {
+        return rows.capacity()*sizeof(Index) + cols.capacity()*sizeof(Index) + errors.capacity()*sizeof(LineError);
+    }
+};
+
+// The index width is picked based on the dimensions from the size line.
+using AnyIndexArrays = std::variant<IndexArrays<uint32_t>, IndexArrays<uint64_t>>;
+
+struct MatrixSize {
+    size_t rows = 0;
+    size_t cols = 0;
+    size_t nnz = 0;
+};
+
+// Reads the `rows cols nnz` line following the comments at the top. Sets `next` to the first entry.
+bool parse_size_line(const char* begin, const char* end, MatrixSize& size, const char*& next) {
+    const char* p = begin;
+    while (p < end && *p == '%') {
+        p = next_line(find_line_end(p, end), end);
+    }
+
+    const char* line_end = find_line_end(p, end);
+    next = next_line(line_end, end);
+
+    size_t* fields[] = { &size.rows, &size.cols, &size.nnz };
+    for (size_t* field : fields) {
+        while (p < line_end && is_space(*p)) {
+            ++p;
+        }
+        if (p >= line_end || !is_digit(*p) || !parse_single_buf(p, line_end, p, *field)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename Index, typename BufFunc>
+void load_index_arrays(const char* begin, const char* end, BufFunc func, IndexArrays<Index>& out) {
+    constexpr size_t max_index = std::numeric_limits<Index>::max();
+
+    const char* p = skip_header(begin, end);
+    size_t line = std::count(begin, p, '\n') + 1;
+
+    for (; p < end; ++line) {
+        Result res = func(p, end, p);
+        if (res.err == ErrCode::success && res.row <= max_index && res.col <= max_index) {
+            out.rows.push_back(static_cast<Index>(res.row));
+            out.cols.push_back(static_cast<Index>(res.col));
+        } else if (res.err == ErrCode::empty) {
+            ++out.empty;
+        } else {
+            out.errors.push_back({ line, ErrCode::error });
+        }
+    }
+}
+
+// Loads the whole buffer choosing 32-bit indices whenever the dimensions allow it.
+template<typename BufFunc>
+bool load_index_arrays(const char* begin, const char* end, BufFunc func, AnyIndexArrays& out) {
+    MatrixSize size;
+    const char* next;
+    if (!parse_size_line(begin, end, size, next)) {
+        return false;
+    }
+
+    if (size.rows <= std::numeric_limits<uint32_t>::max() && size.cols <= std::numeric_limits<uint32_t>::max()) {
+        out.emplace<IndexArrays<uint32_t>>();
+    } else {
+        out.emplace<IndexArrays<uint64_t>>();
+    }
+
+    std::visit([&] (auto& arrays) { load_index_arrays(begin, end, func, arrays); }, out);
+    return true;
+}
+
+// Why a line could not be loaded, for the error messages. The position is where the parsing went
+// wrong, the line counted from 1 including the header and the column counted from 1 in bytes.
+struct LineDiagnostic {
+    size_t line;
+    size_t column;
+    std::string reason;
+};
+
+// The slow and precise path for a line which is already known to have failed. Walks it again with
+// from_chars, the reference all the other implementations are tested against.
+LineDiagnostic diagnose_line(const char* line_begin, const char* line_end, size_t max_index) {
+    const char* p = line_begin;
+    auto at = [&] (std::string reason) {
+        return LineDiagnostic{ 0, static_cast<size_t>(p - line_begin) + 1, std::move(reason) };
+    };
+
+    for (const char* field : { "row", "column" }) {
+        while (p < line_end && is_space(*p)) {
+            ++p;
+        }
+        if (p >= line_end) {
+            return at(std::string("the ") + field + " index is missing");
+        }
+
+        size_t value = 0;
+        auto res = std::from_chars(p, line_end, value);
+        if (res.ec == std::errc::invalid_argument) {
+            return at(std::string("expected the ") + field + " index, found '" + *p + "'");
+        }
+        if (res.ec == std::errc::result_out_of_range || value > max_index) {
+            unsigned bits = max_index == std::numeric_limits<uint32_t>::max() ? 32 : 64;
+            return at(std::string("the ") + field + " index does not fit into " + std::to_string(bits) + " bits");
+        }
+        p = res.ptr;
+    }
+
+    // the fast kernel failed, but from_chars does not, then one of them is wrong
+    return at("no error found on a second look");
+}
+
+// load_index_arrays() builds the error list as it goes. This one only remembers where the failed lines
+// begin and does not look at them at all until the whole buffer is done. Then just those lines are
+// parsed again by diagnose_line(), which also says where and why they failed. Their line numbers come
+// for free, every line before a failed one is either in the arrays, empty or failed too.
+template<typename Index, typename BufFunc>
+void load_index_arrays_optimistic(const char* begin, const char* end, BufFunc func, IndexArrays<Index>& out,
+                                  std::vector<LineDiagnostic>& diagnostics) {
+    constexpr size_t max_index = std::numeric_limits<Index>::max();
+
+    struct FailedLine {
+        const char* begin;
+        size_t line;
+    };
+    std::vector<FailedLine> failed;
+
+    const char* p = skip_header(begin, end);
+    const size_t first_line = std::count(begin, p, '\n') + 1;
+    while (p < end) {
+        const char* line_begin = p;
+        Result res = func(p, end, p);
+        if (res.err == ErrCode::success && res.row <= max_index && res.col <= max_index) {
+            out.rows.push_back(static_cast<Index>(res.row));
+            out.cols.push_back(static_cast<Index>(res.col));
+        } else if (res.err == ErrCode::empty) {
+            ++out.empty;
+        } else {
+            failed.push_back({ line_begin, first_line + out.rows.size() + out.empty + failed.size() });
+        }
+    }
+
+    diagnostics.clear();
+    for (const auto& [line_begin, line] : failed) {
+        LineDiagnostic diagnostic = diagnose_line(line_begin, find_line_end(line_begin, end), max_index);
+        diagnostic.line = line;
+        out.errors.push_back({ line, ErrCode::error });
+        diagnostics.push_back(std::move(diagnostic));
+    }
+}
+
+// What the arrays replace, every line ends up as a `Result`.
+template<typename BufFunc>
+std::vector<Result> load_results(const char* begin, const char* end, BufFunc func) {
+    std::vector<Result> results;
+    const char* p = skip_header(begin, end);
+    while (p < end) {
+        results.push_back(func(p, end, p));
+    }
+    return results;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                MATRIX MARKET LOADER                            //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// Knowing the header up front, the arrays can be allocated exactly once and every entry
+// can be checked against the declared dimensions right away.
+
+struct MatrixMarketHeader {
+    // matrix, coordinate, real/integer/complex/pattern, general/symmetric/...
+    std::string object;
+    std::string format;
+    std::string field;
+    std::string symmetry;
+    MatrixSize size;
+};
+
+template<typename Index, typename Alloc = std::allocator<Index>>
+struct MatrixMarket {
+    MatrixMarketHeader header;
+    IndexArrays<Index, Alloc> arrays;
+};
+
+// Returns the next whitespace separated token on the line and moves `p` past it.
+std::string next_token(const char*& p, const char* line_end) {
+    while (p < line_end && is_space(*p)) {
+        ++p;
+    }
+    const char* token = p;
+    while (p < line_end && !is_space(*p)) {
+        ++p;
+    }
+
+    std::string res(token, p);
+    // the banner is case insensitive
+    std::transform(res.begin(), res.end(), res.begin(), [] (unsigned char c) { return char(tolower(c)); });
+    return res;
+}
+
+// Parses the `%%MatrixMarket` banner and the size line, `next` is set to the first entry.
+// Only the coordinate format is supported, the array one does not have any indices.
+bool parse_header(const char* begin, const char* end, MatrixMarketHeader& header, const char*& next) {
+    const char* p = begin;
+    const char* line_end = find_line_end(p, end);
+
+    if (next_token(p, line_end) != "%%matrixmarket") {
+        return false;
+    }
+
+    header.object = next_token(p, line_end);
+    header.format = next_token(p, line_end);
+    header.field = next_token(p, line_end);
+    header.symmetry = next_token(p, line_end);
+
+    if (header.object != "matrix" || header.format != "coordinate") {
+        return false;
+    }
+
+    return parse_size_line(next_line(line_end, end), end, header.size, next);
+}
+
+// The indices in the file are 1-based, anything outside of the declared dimensions is an error.
+template<typename Index, typename Alloc, typename BufFunc>
+bool load_matrix_market(const char* begin, const char* end, BufFunc func, MatrixMarket<Index, Alloc>& out) {
+    const char* p;
+    if (!parse_header(begin, end, out.header, p)) {
+        return false;
+    }
+
+    const MatrixSize size = out.header.size;
+    if (size.rows > std::numeric_limits<Index>::max() || size.cols > std::numeric_limits<Index>::max()) {
+        return false;
+    }
+
+    // the nnz comes from the file, but every entry takes at least "1 1\n", so the rest of the buffer
+    // bounds how much can be needed
+    IndexArrays<Index, Alloc>& arrays = out.arrays;
+    const size_t max_entries = (end - p + 1)/4;
+    arrays.rows.reserve(std::min(size.nnz, max_entries));
+    arrays.cols.reserve(std::min(size.nnz, max_entries));
+
+    STAGE_TIMER(parse);
+    size_t line = std::count(begin, p, '\n') + 1;
+    [[maybe_unused]] const size_t first_line = line;
+
+    for (; p < end; ++line) {
+        Result res = func(p, end, p);
+        if (res.err == ErrCode::success && res.row - 1 < size.rows && res.col - 1 < size.cols) {
+            arrays.rows.push_back(static_cast<Index>(res.row));
+            arrays.cols.push_back(static_cast<Index>(res.col));
+        } else if (res.err == ErrCode::empty) {
+            ++arrays.empty;
+        } else {
+            arrays.errors.push_back({ line, ErrCode::error });
+        }
+    }
+
+    STAGE_BYTES(parse, end - begin);
+    STAGE_LINES(parse, line - first_line, arrays.empty, arrays.errors.size());
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                CSR CONVERSION                                  //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// What my application actually works with. The entries of row `r` are `col_idx[row_ptr[r]]` up to
+// `col_idx[row_ptr[r + 1]]`, sorted by column. Everything is 0-based, unlike in the file.
+template<typename Index>
+struct CsrMatrix {
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<size_t> row_ptr;
+    std::vector<Index> col_idx;
+};
+
+// Calls `func(thread, n_threads)` on `n_threads` threads, the calling thread being thread 0.
+template<typename Func>
+void run_on_threads(size_t n_threads, Func func) {
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < n_threads; ++t) {
+        threads.emplace_back([&func, t, n_threads] {
+            STAGE_THREAD(t);
+            func(t, n_threads);
+        });
+    }
+    STAGE_THREAD(0);
+    func(size_t(0), n_threads);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// The part of [0, size) which belongs to thread `t` of `n`.
+std::pair<size_t, size_t> thread_range(size_t size, size_t t, size_t n) {
+    return { size*t/n, size*(t + 1)/n };
+}
+
+// Counting sort of the entries by row. The rows are counted with atomic increments, turned into
+// the row pointers with a parallel prefix sum and then every entry is scattered to its row, again
+// claiming its position with an atomic increment. The order within a row depends on the timing
+// of the threads, so in the end every row is sorted by column, which also makes the result the same
+// for any number of threads. The entries must be within the dimensions, as load_matrix_market ensures.
+template<typename Index>
+void build_csr(const MatrixMarket<Index>& matrix, size_t n_threads, CsrMatrix<Index>& csr) {
+    STAGE_TIMER(csr);
+    const std::vector<Index>& rows = matrix.arrays.rows;
+    const std::vector<Index>& cols = matrix.arrays.cols;
+    const size_t nnz = rows.size();
+    const size_t n_rows = matrix.header.size.rows;
+
+    csr.rows = n_rows;
+    csr.cols = matrix.header.size.cols;
+    csr.row_ptr.assign(n_rows + 1, 0);
+    csr.col_idx.resize(nnz);
+
+    // the counts of row r go into slot r + 1, so after the prefix sum slot r is where row r begins
+    std::vector<std::atomic<size_t>> cursor(n_rows + 1);
+    run_on_threads(n_threads, [&] (size_t t, size_t n) {
+        auto [lo, hi] = thread_range(nnz, t, n);
+        for (size_t i = lo; i < hi; ++i) {
+            cursor[rows[i]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    // every thread sums up its block of rows, then offsets it by the sums of the blocks in front of it
+    std::vector<size_t> block_sums(n_threads + 1, 0);
+    run_on_threads(n_threads, [&] (size_t t, size_t n) {
+        auto [lo, hi] = thread_range(n_rows + 1, t, n);
+        size_t sum = 0;
+        for (size_t r = lo; r < hi; ++r) {
+            sum += cursor[r].load(std::memory_order_relaxed);
+        }
+        block_sums[t + 1] = sum;
+    });
+    for (size_t t = 0; t < n_threads; ++t) {
+        block_sums[t + 1] += block_sums[t];
+    }
+    run_on_threads(n_threads, [&] (size_t t, size_t n) {
+        auto [lo, hi] = thread_range(n_rows + 1, t, n);
+        size_t sum = block_sums[t];
+        for (size_t r = lo; r < hi; ++r) {
+            sum += cursor[r].load(std::memory_order_relaxed);
+            csr.row_ptr[r] = sum;
+            cursor[r].store(sum, std::memory_order_relaxed);
+        }
+    });
+
+    // the cursors now point at the beginning of every 0-based row
+    run_on_threads(n_threads, [&] (size_t t, size_t n) {
+        auto [lo, hi] = thread_range(nnz, t, n);
+        for (size_t i = lo; i < hi; ++i) {
+            size_t pos = cursor[rows[i] - 1].fetch_add(1, std::memory_order_relaxed);
+            csr.col_idx[pos] = static_cast<Index>(cols[i] - 1);
+        }
+    });
+
+    run_on_threads(n_threads, [&] (size_t t, size_t n) {
+        auto [lo, hi] = thread_range(n_rows, t, n);
+        for (size_t r = lo; r < hi; ++r) {
+            // most rows of a sparse matrix have only a handful of entries
+            if (csr.row_ptr[r + 1] - csr.row_ptr[r] > 1) {
+                std::sort(csr.col_idx.begin() + csr.row_ptr[r], csr.col_idx.begin() + csr.row_ptr[r + 1]);
+            }
+        }
+    });
+}
+
+// What the conversion usually looks like, sorting all the entries by row and column and then
+// counting the rows.
+template<typename Index>
+void build_csr_sort(const MatrixMarket<Index>& matrix, CsrMatrix<Index>& csr) {
+    const size_t nnz = matrix.arrays.rows.size();
+    std::vector<std::pair<Index, Index>> entries(nnz);
+    for (size_t i = 0; i < nnz; ++i) {
+        entries[i] = { static_cast<Index>(matrix.arrays.rows[i] - 1), static_cast<Index>(matrix.arrays.cols[i] - 1) };
+    }
+    std::sort(entries.begin(), entries.end());
+
+    csr.rows = matrix.header.size.rows;
+    csr.cols = matrix.header.size.cols;
+    csr.row_ptr.assign(csr.rows + 1, 0);
+    csr.col_idx.resize(nnz);
+    for (size_t i = 0; i < nnz; ++i) {
+        ++csr.row_ptr[entries[i].first + 1];
+        csr.col_idx[i] = entries[i].second;
+    }
+    for (size_t r = 0; r < csr.rows; ++r) {
+        csr.row_ptr[r + 1] += csr.row_ptr[r];
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                BINARY CACHE                                    //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// The same files get loaded over and over, so after the first time the parsed index arrays are written
+// next to the file (`<path>.idx`) and on the next run they are mapped directly without parsing anything.
+// The layout is the header followed by the rows, the cols and the errors as (line, error code) pairs.
+// Everything is in the native byte order, the cache is meant for the machine which wrote it.
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t index_width;
+    // the size line of the file
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t nnz;
+    // what ended up in the arrays
+    uint64_t entries;
+    uint64_t empty;
+    uint64_t errors;
+    // the cache is thrown away if any of these changed
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+};
+
+static_assert(sizeof(CacheHeader) % 8 == 0, "the arrays after the header must stay aligned");
+
+constexpr char cache_magic[8] = { 'I', 'P', 'M', 'T', 'X', 'I', 'D', 'X' };
+constexpr uint32_t cache_version = 1;
+
+std::string cache_path(const std::string& path) {
+    return path + ".idx";
+}
+
+// Hashing the whole file would take about as long as parsing it, so only its beginning and end
+// are hashed, together with the size and the modification time that should catch any change.
+bool source_identity(const std::string& path, CacheHeader& header) {
+    constexpr size_t sample_size = 64 << 10;
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    header.source_size = size;
+    header.source_mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::vector<char> sample(sample_size);
+    uint64_t hash = 14695981039346656037ull;
+    auto hash_sample = [&] (size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(sample[i])) * 1099511628211ull;
+        }
+    };
+    hash_sample(fread(sample.data(), 1, sample.size(), file));
+    if (size > sample_size) {
+        fseek(file, -static_cast<long>(std::min<uint64_t>(size - sample_size, sample_size)), SEEK_END);
+        hash_sample(fread(sample.data(), 1, sample.size(), file));
+    }
+    fclose(file);
+
+    header.source_hash = hash;
+    return true;
+}
+
+size_t cache_errors_offset(size_t entries, size_t index_width) {
+    size_t offset = sizeof(CacheHeader) + 2*entries*index_width;
+    return (offset + 7) / 8 * 8;
+}
+
+// Written into a temporary file first and then renamed, so a job killed in the middle never leaves
+// a broken cache behind.
+template<typename Index>
+bool write_cache(const std::string& path, const MatrixMarket<Index>& matrix) {
+    const IndexArrays<Index>& arrays = matrix.arrays;
+
+    CacheHeader header = {};
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.index_width = sizeof(Index);
+    header.rows = matrix.header.size.rows;
+    header.cols = matrix.header.size.cols;
+    header.nnz = matrix.header.size.nnz;
+    header.entries = arrays.rows.size();
+    header.empty = arrays.empty;
+    header.errors = arrays.errors.size();
+    if (!source_identity(path, header)) {
+        return false;
+    }
+
+    std::vector<uint64_t> errors;
+    for (const auto& error : arrays.errors) {
+        errors.push_back(error.line);
+        errors.push_back(static_cast<uint64_t>(error.err));
+    }
+
+    std::string tmp_path = cache_path(path) + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary);
+        const size_t padding = cache_errors_offset(arrays.rows.size(), sizeof(Index)) 
+                             - sizeof(CacheHeader) - 2*arrays.rows.size()*sizeof(Index);
+        const char zeros[8] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(arrays.rows.data()), arrays.rows.size()*sizeof(Index));
+        out.write(reinterpret_cast<const char*>(arrays.cols.data()), arrays.cols.size()*sizeof(Index));
+        out.write(zeros, padding);
+        out.write(reinterpret_cast<const char*>(errors.data()), errors.size()*sizeof(uint64_t));
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, cache_path(path), ec);
+    return !ec;
+}
+
+// The arrays straight from the mapped cache, nothing is copied.
+template<typename Index>
+class CachedMatrix {
+public:
+    // Fails if there is no cache for `path`, or it was made for a different version of the file or index type.
+    bool open(const std::string& path) {
+        file_ = std::make_unique<MappedFile>(cache_path(path));
+        header_ = nullptr;
+        if (!file_->ok() || file_->size() < sizeof(CacheHeader)) {
+            return false;
+        }
+
+        const CacheHeader* header = reinterpret_cast<const CacheHeader*>(file_->data());
+        if (memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 || header->version != cache_version 
+                || header->index_width != sizeof(Index)) {
+            return false;
+        }
+        if (cache_errors_offset(header->entries, sizeof(Index)) + 2*header->errors*sizeof(uint64_t) != file_->size()) {
+            return false;
+        }
+
+        CacheHeader source;
+        if (!source_identity(path, source) || source.source_size != header->source_size 
+                || source.source_mtime != header->source_mtime || source.source_hash != header->source_hash) {
+            return false;
+        }
+
+        header_ = header;
+        return true;
+    }
+
+    const CacheHeader& header() const { return *header_; }
+    size_t entries() const { return header_->entries; }
+    const Index* rows() const { return reinterpret_cast<const Index*>(file_->data() + sizeof(CacheHeader)); }
+    const Index* cols() const { return rows() + entries(); }
+
+    std::vector<LineError> errors() const {
+        const char* p = file_->data() + cache_errors_offset(entries(), sizeof(Index));
+        std::vector<LineError> errors(header_->errors);
+        for (auto& error : errors) {
+            uint64_t pair[2];
+            memcpy(pair, p, sizeof(pair));
+            p += sizeof(pair);
+            error = { static_cast<size_t>(pair[0]), static_cast<ErrCode>(pair[1]) };
+        }
+        return errors;
+    }
+
+private:
+    std::unique_ptr<MappedFile> file_;
+    const CacheHeader* header_ = nullptr;
+};
+
+// Maps the cache of the file if there is a valid one, otherwise parses the file and writes the cache
+// first. `from_cache` tells which of it happened.
+template<typename Index, typename BufFunc>
+bool load_matrix_cached(const std::string& path, BufFunc func, CachedMatrix<Index>& out, bool& from_cache) {
+    from_cache = out.open(path);
+    if (from_cache) {
+        return true;
+    }
+
+    MatrixMarket<Index> matrix;
+    {
+        MappedFile file(path);
+        if (!file.ok() || !load_matrix_market(file.begin(), file.end(), func, matrix)) {
+            return false;
+        }
+    }
+    return write_cache(path, matrix) && out.open(path);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                ARENA                                           //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// Our jobs load hundreds of files in a row and every one of them allocates and frees its own arrays.
+// The arena hands out memory from big blocks by just bumping a pointer, nothing is freed on its own
+// and reset() makes all of it available again for the next file. If the file needed more than one
+// block, reset() replaces them by a single block large enough for all of them, so from the second
+// file on there are usually no allocations (and no fresh pages to fault in) at all.
+class Arena {
+public:
+    explicit Arena(size_t block_size = 1 << 20) : block_size_(std::max<size_t>(block_size, 64)) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) {
+        if (!blocks_.empty()) {
+            Block& block = blocks_.back();
+            size_t offset = (used_ + align - 1) / align * align;
+            if (offset + bytes <= block.size) {
+                used_ = offset + bytes;
+                return block.data.get() + offset;
+            }
+        }
+
+        // the blocks grow so a large array does not end up in lots of small ones
+        size_t size = std::max({ block_size_, bytes + align, blocks_.empty() ? 0 : 2*blocks_.back().size });
+        add_block(size);
+        return allocate(bytes, align);
+    }
+
+    // Everything allocated before is invalid afterwards.
+    void reset() {
+        if (blocks_.size() > 1) {
+            size_t total = 0;
+            for (const auto& block : blocks_) {
+                total += block.size;
+            }
+            blocks_.clear();
+            add_block(total);
+        }
+        used_ = 0;
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block.size;
+        }
+        return total;
+    }
+
+    // how many blocks were allocated so far, including the ones reset() replaced
+    size_t allocations() const {
+        return allocations_;
+    }
+
+private:
+    struct Block {
+        // new char[] leaves the memory untouched, so the pages are only faulted in once they are used
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    void add_block(size_t size) {
+        blocks_.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        used_ = 0;
+        ++allocations_;
+    }
+
+    size_t block_size_;
+    std::vector<Block> blocks_;
+    // how much of the last block is taken
+    size_t used_ = 0;
+    size_t allocations_ = 0;
+};
+
+// So the standard containers can put their elements into an Arena. Deallocating does nothing,
+// the memory comes back with the next reset() of the arena.
+template<typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) : arena(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) {}
+
+    Arena* arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+template<typename Index>
+using ArenaMatrixMarket = MatrixMarket<Index, ArenaAllocator<Index>>;
+
+template<typename Index>
+ArenaMatrixMarket<Index> make_arena_matrix(Arena& arena) {
+    return { {}, IndexArrays<Index, ArenaAllocator<Index>>(ArenaAllocator<Index>(arena)) };
+}
+
+// std::allocator which counts its allocations, so the arena benchmark can compare the std::vector
+// arrays with the blocks of the arena without replacing the allocator of the whole program.
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator(size_t& count) : count(&count) {}
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : count(other.count) {}
+
+    T* allocate(size_t n) {
+        ++*count;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    size_t* count;
+};
+
+template<typename T, typename U>
+bool operator==(const CountingAllocator<T>& a, const CountingAllocator<U>& b) {
+    return a.count == b.count;
+}
+
+template<typename T, typename U>
+bool operator!=(const CountingAllocator<T>& a, const CountingAllocator<U>& b) {
+    return a.count != b.count;
+}
+
+template<typename Index>
+using CountingMatrixMarket = MatrixMarket<Index, CountingAllocator<Index>>;
+
+template<typename Index>
+CountingMatrixMarket<Index> make_counting_matrix(size_t& count) {
+    return { {}, IndexArrays<Index, CountingAllocator<Index>>(CountingAllocator<Index>(count)) };
+}
+
+// Minor and major page faults of the process so far.
+size_t page_faults() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PageFaultCount;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_minflt + usage.ru_majflt);
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                COMPRESSED INPUT                                //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// A gzip file is a sequence of members which can each be decompressed on their own, but where one ends
+// is only known once it is decompressed. Except in BGZF (what bgzip from htslib writes), where every
+// member is at most 64 KiB and carries its compressed size in an extra field of its header. So those
+// can be split across threads right away, and the size of every member's output is in its last four
+// bytes, so every thread can decompress straight to the right place of the final buffer. Anything
+// else is decompressed with a single thread. zstd would work the same way with its frames, but I have
+// no library for it here.
+
+#ifdef HAVE_ZLIB
+
+struct GzipMember {
+    const unsigned char* data;
+    size_t size;
+    // where the output goes in the decompressed buffer and how large it is
+    size_t offset;
+    size_t output_size;
+};
+
+uint16_t read_le16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t read_le32(const unsigned char* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+// Finds the members of a BGZF file, returns false if it is anything else (including plain gzip).
+bool find_bgzf_members(const char* begin, const char* end, std::vector<GzipMember>& members) {
+    members.clear();
+    auto p = reinterpret_cast<const unsigned char*>(begin);
+    auto last = reinterpret_cast<const unsigned char*>(end);
+    size_t offset = 0;
+
+    while (p < last) {
+        // the fixed header, FEXTRA set, the extra field being exactly the 'BC' subfield with the size
+        if (last - p < 18 + 8 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || p[3] != 4 || read_le16(p + 10) != 6 
+                || p[12] != 'B' || p[13] != 'C' || read_le16(p + 14) != 2) {
+            return false;
+        }
+        size_t size = size_t(read_le16(p + 16)) + 1;
+        if (size < 18 + 8 || size > size_t(last - p)) {
+            return false;
+        }
+
+        // the size comes from the file, bgzip never puts more than 64 KiB into a member and anything
+        // bigger is left to inflate_gzip, rather than allocating up to 4 GiB per member up front
+        size_t output_size = read_le32(p + size - 4);
+        if (output_size > (1 << 16)) {
+            return false;
+        }
+        members.push_back({ p, size, offset, output_size });
+        offset += output_size;
+        p += size;
+    }
+    return !members.empty();
+}
+
+// Decompresses a single member, whose output size is known, straight into `dst`.
+bool inflate_member(z_stream& stream, const GzipMember& member, char* dst) {
+    if (inflateReset(&stream) != Z_OK) {
+        return false;
+    }
+    stream.next_in = const_cast<Bytef*>(member.data);
+    stream.avail_in = static_cast<uInt>(member.size);
+    stream.next_out = reinterpret_cast<Bytef*>(dst);
+    stream.avail_out = static_cast<uInt>(member.output_size);
+    return inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.avail_out == 0;
+}
+
+// Any gzip file, member after member on the calling thread. Appends to `out`.
+bool inflate_gzip(const char* begin, const char* end, std::vector<char>& out) {
+    STAGE_TIMER(decompress);
+    z_stream stream{};
+    // 16 means a gzip header instead of a zlib one
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return false;
+    }
+
+    // zlib counts in 32 bits, so a large file is fed to it in pieces
+    const char* next_in = begin;
+    auto refill = [&] {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(next_in));
+        stream.avail_in = static_cast<uInt>(std::min<size_t>(end - next_in, UINT_MAX));
+        next_in += stream.avail_in;
+    };
+    refill();
+
+    [[maybe_unused]] const size_t initial_size = out.size();
+    size_t size = out.size();
+    int status = Z_OK;
+    while (true) {
+        if (stream.avail_in == 0) {
+            refill();
+        }
+        if (status == Z_STREAM_END) {
+            // the end of a member, another one may follow
+            if (stream.avail_in == 0 || inflateReset(&stream) != Z_OK) {
+                break;
+            }
+        }
+        if (size == out.size()) {
+            out.resize(std::max<size_t>(out.size()*2, 1 << 20));
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(out.data() + size);
+        stream.avail_out = static_cast<uInt>(std::min<size_t>(out.size() - size, UINT_MAX));
+        size_t available = stream.avail_out;
+        status = inflate(&stream, Z_NO_FLUSH);
+        size += available - stream.avail_out;
+        if (status != Z_OK && status != Z_STREAM_END) {
+            break;
+        }
+    }
+
+    STAGE_BYTES(decompress, size - initial_size);
+    out.resize(size);
+    inflateEnd(&stream);
+    return status == Z_STREAM_END && stream.avail_in == 0;
+}
+
+// Decompresses a whole gzip file into `out`, a BGZF one with `n_threads` threads each taking a
+// consecutive range of the members. The kernels then work directly on `out`.
+bool decompress_gzip(const char* begin, const char* end, size_t n_threads, std::vector<char>& out) {
+    std::vector<GzipMember> members;
+    out.clear();
+    if (!find_bgzf_members(begin, end, members)) {
+        return inflate_gzip(begin, end, out);
+    }
+
+    out.resize(members.back().offset + members.back().output_size);
+    std::vector<char> failed(n_threads, false);
+
+    run_on_threads(n_threads, [&] (size_t t, size_t n) {
+        STAGE_TIMER(decompress);
+        z_stream stream{};
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+            failed[t] = true;
+            return;
+        }
+        auto [first, last] = thread_range(members.size(), t, n);
+        for (size_t i = first; i < last && !failed[t]; ++i) {
+            failed[t] = !inflate_member(stream, members[i], out.data() + members[i].offset);
+            STAGE_BYTES(decompress, members[i].output_size);
+        }
+        inflateEnd(&stream);
+    });
+
+    return std::find(failed.begin(), failed.end(), true) == failed.end();
+}
+
+// Writes `data` as a BGZF file, so it can be decompressed in parallel, and `gzip -d` still reads it.
+bool write_bgzf(const std::string& path, const char* data, size_t size, int level = 6) {
+    // what bgzip uses, so that even incompressible data fits into a member of 64 KiB
+    constexpr size_t max_input = 0xff00;
+    constexpr size_t max_member = 1 << 16;
+
+    std::ofstream out(path, std::ios::binary);
+    std::vector<unsigned char> member(max_member);
+
+    z_stream stream{};
+    // negative window bits for raw deflate, the gzip header and trailer are written by hand
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    auto put_le = [] (unsigned char* p, uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            p[i] = static_cast<unsigned char>(value >> (8*i));
+        }
+    };
+
+    // the last member is empty, the marker bgzip uses for the end of the file
+    bool ok = true;
+    for (size_t pos = 0; ; ) {
+        size_t input = std::min(max_input, size - pos);
+
+        const unsigned char header[18] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0 };
+        std::memcpy(member.data(), header, sizeof(header));
+
+        deflateReset(&stream);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + pos));
+        stream.avail_in = static_cast<uInt>(input);
+        stream.next_out = member.data() + 18;
+        stream.avail_out = static_cast<uInt>(max_member - 18 - 8);
+        ok = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+        if (!ok) {
+            break;
+        }
+
+        size_t member_size = 18 + stream.total_out + 8;
+        put_le(member.data() + 16, static_cast<uint32_t>(member_size - 1), 2);
+        uLong crc = crc32(0, reinterpret_cast<const Bytef*>(data + pos), static_cast<uInt>(input));
+        put_le(member.data() + 18 + stream.total_out, static_cast<uint32_t>(crc), 4);
+        put_le(member.data() + 18 + stream.total_out + 4, static_cast<uint32_t>(input), 4);
+        out.write(reinterpret_cast<const char*>(member.data()), member_size);
+
+        pos += input;
+        if (input == 0) {
+            break;
+        }
+    }
+
+    deflateEnd(&stream);
+    return ok && static_cast<bool>(out);
+}
+
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                LOADER TESTS                                    //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+// The tests run on every start, so the fixtures they write into the temp directory are removed
+// again however the test ends. Declared before anything maps the files. A directory is removed
+// together with everything in it.
+struct TempFiles {
+    std::vector<std::string> paths;
+
+    ~TempFiles() {
+        for (const auto& path : paths) {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    }
+};
+
+void test_matrix_market() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: matrix market\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    auto load = [] (const std::string& content, MatrixMarket<uint32_t>& matrix) {
+        return load_matrix_market(content.data(), content.data() + content.size(), parse_custom_buf, matrix);
+    };
+
+    std::string content = 
+        "%%MatrixMarket Matrix Coordinate Real General\n"
+        "% a comment\n"
+        "%\n"
+        "  3 4   5\n"
+        "1 1 1.0\n"
+        "3 4 2.0\n"
+        "\n"
+        "0 1 3.0\n"
+        "4 1 4.0\n"
+        "1 5 5.0\n"
+        "2 x\n"
+        "2 2";
+
+    MatrixMarket<uint32_t> matrix;
+    if (!load(content, matrix)) {
+        return fail("valid file rejected");
+    }
+
+    const MatrixMarketHeader& header = matrix.header;
+    if (header.object != "matrix" || header.format != "coordinate" || header.field != "real" || header.symmetry != "general") {
+        return fail("wrong banner: " + header.object + " " + header.format + " " + header.field + " " + header.symmetry);
+    }
+    if (header.size.rows != 3 || header.size.cols != 4 || header.size.nnz != 5) {
+        return fail("wrong size line");
+    }
+
+    const IndexArrays<uint32_t>& arrays = matrix.arrays;
+    if (arrays.rows != std::vector<uint32_t>{ 1, 3, 2 } || arrays.cols != std::vector<uint32_t>{ 1, 4, 2 }) {
+        return fail("wrong entries");
+    }
+    if (arrays.rows.capacity() < header.size.nnz) {
+        return fail("arrays not pre-sized");
+    }
+    if (arrays.empty != 1) {
+        return fail("wrong number of empty lines");
+    }
+
+    std::vector<size_t> error_lines;
+    for (const auto& error : arrays.errors) {
+        error_lines.push_back(error.line);
+    }
+    if (error_lines != std::vector<size_t>{ 8, 9, 10, 11 }) {
+        return fail("wrong error lines");
+    }
+
+    if (load("%%MatrixMarket matrix array real general\n3 4\n", matrix)) {
+        return fail("array format accepted");
+    }
+    if (load("% just a comment\n3 4 5\n1 1 1.0\n", matrix)) {
+        return fail("missing banner accepted");
+    }
+    if (load("%%MatrixMarket matrix coordinate real general\n3 4\n", matrix)) {
+        return fail("incomplete size line accepted");
+    }
+    if (load("%%MatrixMarket matrix coordinate real general\n4294967296 4 5\n", matrix)) {
+        return fail("too many rows for 32-bit indices accepted");
+    }
+
+    MatrixMarket<uint32_t> lying;
+    if (!load("%%MatrixMarket matrix coordinate real general\n3 4 1000000000000\n1 1 1.0\n2 2", lying)
+            || lying.arrays.rows.size() != 2 || lying.arrays.rows.capacity() > 3) {
+        return fail("wrong result with an nnz larger than the file");
+    }
+
+    std::cerr << "TEST PASSED: matrix market\n";
+}
+
+void test_optimistic() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: optimistic loading\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    std::string content =
+        "%%MatrixMarket matrix coordinate real general\n"
+        "% a comment\n"
+        "3 4 5\n"
+        "1 1 1.0\n"
+        "12 x 1.0\n"
+        "\n"
+        "  -3 4\n"
+        "2 2\n"
+        "7\t\n"
+        "99999999999999999999 1\n"
+        "4294967296 1\n"
+        "3 4";
+    const char* begin = content.data();
+    const char* end = content.data() + content.size();
+
+    IndexArrays<uint32_t> expected;
+    load_index_arrays(begin, end, parse_simd_buf, expected);
+
+    IndexArrays<uint32_t> actual;
+    std::vector<LineDiagnostic> diagnostics;
+    load_index_arrays_optimistic(begin, end, parse_simd_buf, actual, diagnostics);
+
+    if (actual.rows != expected.rows || actual.cols != expected.cols || actual.empty != expected.empty) {
+        return fail("different entries than load_index_arrays");
+    }
+    if (actual.errors.size() != expected.errors.size() || diagnostics.size() != expected.errors.size()) {
+        return fail("different number of errors than load_index_arrays");
+    }
+
+    std::vector<LineDiagnostic> wanted = {
+        { 5, 4, "expected the column index, found 'x'" },
+        { 7, 3, "expected the row index, found '-'" },
+        { 9, 3, "the column index is missing" },
+        { 10, 1, "the row index does not fit into 32 bits" },
+        { 11, 1, "the row index does not fit into 32 bits" },
+    };
+    for (size_t i = 0; i < wanted.size(); ++i) {
+        const LineDiagnostic& d = diagnostics[i];
+        if (actual.errors[i].line != expected.errors[i].line || d.line != wanted[i].line 
+                || d.column != wanted[i].column || d.reason != wanted[i].reason) {
+            return fail("wrong diagnostic: " + std::to_string(d.line) + ":" + std::to_string(d.column) + " " + d.reason);
+        }
+    }
+
+    IndexArrays<uint64_t> wide;
+    load_index_arrays_optimistic(begin, end, parse_simd_buf, wide, diagnostics);
+    if (diagnostics.size() != 4 || diagnostics[3].reason != "the row index does not fit into 64 bits") {
+        return fail("wrong diagnostics with 64-bit indices");
+    }
+
+    std::cerr << "TEST PASSED: optimistic loading\n";
+}
+
+void test_csr() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: csr\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    std::string content = 
+        "%%MatrixMarket matrix coordinate real general\n"
+        "4 5 7\n"
+        "3 5 1.0\n"
+        "1 2 2.0\n"
+        "3 1 3.0\n"
+        "1 1 4.0\n"
+        "\n"
+        "3 3 5.0\n"
+        "4 5 6.0\n"
+        "3 3 7.0\n";
+
+    MatrixMarket<uint32_t> matrix;
+    if (!load_matrix_market(content.data(), content.data() + content.size(), parse_custom_buf, matrix)) {
+        return fail("could not load the matrix");
+    }
+
+    // row 2 (1 in the file) is empty, the duplicate entry stays
+    std::vector<size_t> expected_ptr = { 0, 2, 2, 6, 7 };
+    std::vector<uint32_t> expected_idx = { 0, 1, 0, 2, 2, 4, 4 };
+
+    CsrMatrix<uint32_t> sorted;
+    build_csr_sort(matrix, sorted);
+    if (sorted.row_ptr != expected_ptr || sorted.col_idx != expected_idx) {
+        return fail("wrong result from sorting");
+    }
+
+    for (size_t n_threads : { 1, 2, 3, 8 }) {
+        CsrMatrix<uint32_t> csr;
+        build_csr(matrix, n_threads, csr);
+        if (csr.rows != 4 || csr.cols != 5 || csr.row_ptr != expected_ptr || csr.col_idx != expected_idx) {
+            return fail("wrong result from counting sort with " + std::to_string(n_threads) + " threads");
+        }
+    }
+
+    std::cerr << "TEST PASSED: csr\n";
+}
+
+void test_binary_cache() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: binary cache\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    std::string path = (std::filesystem::temp_directory_path() / "integer-parsing-cache-test.mtx").string();
+    TempFiles temp{ { path, cache_path(path) } };
+    std::filesystem::remove(cache_path(path));
+    generate_matrix_file(path, 1000);
+
+    MatrixMarket<uint32_t> expected;
+    {
+        MappedFile file(path);
+        if (!file.ok() || !load_matrix_market(file.begin(), file.end(), parse_custom_buf, expected)) {
+            return fail("could not load " + path);
+        }
+    }
+
+    auto same_as_expected = [&] (const CachedMatrix<uint32_t>& cached) {
+        const IndexArrays<uint32_t>& arrays = expected.arrays;
+        std::vector<LineError> errors = cached.errors();
+        return cached.entries() == arrays.rows.size() && cached.header().empty == arrays.empty
+            && cached.header().nnz == expected.header.size.nnz
+            && std::equal(arrays.rows.begin(), arrays.rows.end(), cached.rows())
+            && std::equal(arrays.cols.begin(), arrays.cols.end(), cached.cols())
+            && std::equal(errors.begin(), errors.end(), arrays.errors.begin(), arrays.errors.end(), 
+                          [] (const LineError& a, const LineError& b) { return a.line == b.line && a.err == b.err; });
+    };
+
+    CachedMatrix<uint32_t> cached;
+    bool from_cache = true;
+    if (!load_matrix_cached(path, parse_custom_buf, cached, from_cache) || from_cache || !same_as_expected(cached)) {
+        return fail("wrong result from the first load");
+    }
+    if (!load_matrix_cached(path, parse_custom_buf, cached, from_cache) || !from_cache || !same_as_expected(cached)) {
+        return fail("wrong result from the cache");
+    }
+
+    CachedMatrix<uint64_t> wide;
+    if (wide.open(path)) {
+        return fail("cache with a different index width accepted");
+    }
+
+    // the modification time alone might not change within its resolution, but the size does
+    std::ofstream(path, std::ios::binary | std::ios::app) << "1 1 1.0\n";
+    if (cached.open(path)) {
+        return fail("cache of a modified file accepted");
+    }
+
+    std::cerr << "TEST PASSED: binary cache\n";
+}
+
+void test_arena() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: arena\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    Arena arena(256);
+    char* a = static_cast<char*>(arena.allocate(3, 1));
+    void* b = arena.allocate(8, 8);
+    if (reinterpret_cast<uintptr_t>(b) % 8 != 0 || static_cast<char*>(b) < a + 3) {
+        return fail("misaligned or overlapping allocation");
+    }
+
+    // too large for the first block, after the reset everything fits into one
+    arena.allocate(1000, 16);
+    arena.reset();
+    size_t capacity = arena.capacity();
+    if (capacity < 1256 || arena.allocate(1200, 1) == nullptr || arena.capacity() != capacity) {
+        return fail("blocks not merged by the reset");
+    }
+    arena.reset();
+    char* first = static_cast<char*>(arena.allocate(3, 1));
+    if (static_cast<char*>(arena.allocate(1, 1)) != first + 3) {
+        return fail("memory not reused after the reset");
+    }
+    arena.reset();
+
+    std::string content = 
+        "%%MatrixMarket matrix coordinate real general\n"
+        "3 4 3\n"
+        "1 1 1.0\n"
+        "3 4 2.0\n"
+        "x\n"
+        "2 2 3.0\n";
+
+    MatrixMarket<uint32_t> expected;
+    load_matrix_market(content.data(), content.data() + content.size(), parse_custom_buf, expected);
+    for (int i = 0; i < 3; ++i) {
+        ArenaMatrixMarket<uint32_t> matrix = make_arena_matrix<uint32_t>(arena);
+        if (!load_matrix_market(content.data(), content.data() + content.size(), parse_custom_buf, matrix)) {
+            return fail("could not load the matrix");
+        }
+        const auto& arrays = matrix.arrays;
+        if (!std::equal(arrays.rows.begin(), arrays.rows.end(), expected.arrays.rows.begin(), expected.arrays.rows.end()) 
+                || !std::equal(arrays.cols.begin(), arrays.cols.end(), expected.arrays.cols.begin(), expected.arrays.cols.end()) 
+                || arrays.errors.size() != 1 || arrays.errors[0].line != 5) {
+            return fail("wrong entries in the arena");
+        }
+        arena.reset();
+    }
+
+    std::cerr << "TEST PASSED: arena\n";
+}
+
+void test_stream_file() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: stream file\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    std::string path = (std::filesystem::temp_directory_path() / "integer-parsing-stream-test.mtx").string();
+    TempFiles temp{ { path } };
+    generate_matrix_file(path, 2000);
+
+    MappedFile file(path);
+    if (!file.ok()) {
+        return fail("could not read " + path);
+    }
+    ParsedFile expected = parse_parallel(file.begin(), file.end(), 1, parse_custom_buf);
+
+    // the small buffers make a lot of the lines straddle a refill
+    // 0 buffers stands for stream_file(), the rest for the pipelined one
+    for (size_t buffer_size : { 64, 100, 4097, 1 << 20 }) {
+        for (size_t n_buffers : { 0, 2, 3 }) {
+            for (auto func : { parse_custom_buf, parse_simd_buf }) {
+                ParsedFile parsed;
+                auto sink = [&] (const Entry* entries, size_t count) {
+                    parsed.entries.insert(parsed.entries.end(), entries, entries + count);
+                };
+                bool ok = n_buffers == 0 ? stream_file(path, buffer_size, func, sink, parsed.stats)
+                                         : stream_file_pipelined(path, buffer_size, n_buffers, func, sink, parsed.stats);
+
+                bool same_entries = parsed.entries.size() == expected.entries.size() 
+                    && std::equal(parsed.entries.begin(), parsed.entries.end(), expected.entries.begin(), 
+                                  [] (const Entry& a, const Entry& b) { return a.row == b.row && a.col == b.col; });
+                if (!ok || !(parsed.stats == expected.stats) || !same_entries) {
+                    return fail("different result with " + std::to_string(n_buffers) + " buffers of " 
+                                + std::to_string(buffer_size) + " bytes");
+                }
+            }
+        }
+    }
+
+    LoadStats stats;
+    if (stream_file(path, 16, parse_custom_buf, [] (const Entry*, size_t) {}, stats)) {
+        return fail("line longer than the buffer accepted");
+    }
+    if (stream_file_pipelined(path, 16, 2, parse_custom_buf, [] (const Entry*, size_t) {}, stats)) {
+        return fail("line longer than the buffer accepted by the pipeline");
+    }
+
+    std::ofstream(path, std::ios::binary) << "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n2 2";
+    stats = {};
+    if (!stream_file(path, 64, parse_custom_buf, [] (const Entry*, size_t) {}, stats) || stats.entries != 2) {
+        return fail("last line without a newline");
+    }
+    stats = {};
+    if (!stream_file_pipelined(path, 64, 2, parse_custom_buf, [] (const Entry*, size_t) {}, stats) || stats.entries != 2) {
+        return fail("last line without a newline in the pipeline");
+    }
+
+    std::cerr << "TEST PASSED: stream file\n";
+}
+
+void test_work_stealing() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: work stealing\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    std::string path = (std::filesystem::temp_directory_path() / "integer-parsing-steal-test.mtx").string();
+    TempFiles temp{ { path } };
+    generate_skewed_file(path, 2000);
+
+    MappedFile file(path);
+    if (!file.ok()) {
+        return fail("could not read " + path);
+    }
+    ParsedFile expected = parse_parallel(file.begin(), file.end(), 1, parse_custom_buf);
+
+    // tiny tasks so the threads really get to steal
+    for (size_t n_threads : { 1, 2, 3, 5 }) {
+        for (size_t task_size : { 1, 64, 1000, 64 << 10 }) {
+            ParsedFile actual = parse_work_stealing(file.begin(), file.end(), n_threads, parse_simd_buf, task_size);
+            bool same = actual.stats == expected.stats && actual.entries.size() == expected.entries.size() &&
+                        std::equal(actual.entries.begin(), actual.entries.end(), expected.entries.begin(), 
+                                   [] (Entry a, Entry b) { return a.row == b.row && a.col == b.col; });
+            if (!same) {
+                return fail("different result with " + std::to_string(n_threads) + " threads and tasks of " 
+                            + std::to_string(task_size) + " bytes");
+            }
+        }
+    }
+
+    std::cerr << "TEST PASSED: work stealing\n";
+}
+
+void test_queue() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: queue\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    // a tiny queue so it is full most of the time, every producer's values have to arrive in order
+    constexpr size_t n_producers = 4;
+    constexpr size_t per_producer = 20'000;
+    BoundedQueue<std::pair<size_t, size_t>> queue(8);
+    std::vector<std::thread> producers;
+    for (size_t t = 0; t < n_producers; ++t) {
+        producers.emplace_back([&queue, t] {
+            for (size_t i = 0; i < per_producer; ++i) {
+                std::pair<size_t, size_t> value = { t, i };
+                while (!queue.try_push(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<size_t> next(n_producers, 0);
+    bool in_order = true;
+    for (size_t received = 0; received < n_producers*per_producer; ) {
+        std::pair<size_t, size_t> value;
+        if (!queue.try_pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        in_order &= value.first < n_producers && value.second == next[value.first]++;
+        ++received;
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+
+    std::pair<size_t, size_t> value;
+    if (!in_order || queue.try_pop(value)) {
+        return fail("values lost, duplicated or out of order");
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "integer-parsing-queue-test.mtx").string();
+    TempFiles temp{ { path } };
+    generate_matrix_file(path, 5000);
+    MappedFile file(path);
+    if (!file.ok()) {
+        return fail("could not read " + path);
+    }
+
+    ParsedFile expected = parse_parallel(file.begin(), file.end(), 1, parse_custom_buf);
+    std::sort(expected.entries.begin(), expected.entries.end(), 
+              [] (Entry a, Entry b) { return std::tie(a.row, a.col) < std::tie(b.row, b.col); });
+
+    for (size_t n : { 1, 3 }) {
+        for (size_t queue_size : { 1, 64 }) {
+            std::vector<Entry> entries;
+            auto consume = [&] (const Entry* batch, size_t count) { entries.insert(entries.end(), batch, batch + count); };
+            LoadStats stats = parse_parallel_queued(file.begin(), file.end(), n, parse_simd_buf, consume, queue_size);
+
+            std::sort(entries.begin(), entries.end(), 
+                      [] (Entry a, Entry b) { return std::tie(a.row, a.col) < std::tie(b.row, b.col); });
+            bool same = stats == expected.stats && entries.size() == expected.entries.size() &&
+                        std::equal(entries.begin(), entries.end(), expected.entries.begin(), 
+                                   [] (Entry a, Entry b) { return a.row == b.row && a.col == b.col; });
+            if (!same) {
+                return fail("different result with " + std::to_string(n) + " producers and a queue of " 
+                            + std::to_string(queue_size));
+            }
+        }
+    }
+
+    std::cerr << "TEST PASSED: queue\n";
+}
+#ifdef HAVE_NUMA
+void test_numa() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: numa\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    std::vector<int> nodes = numa_cpu_nodes();
+    if (nodes.empty()) {
+        return;
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "integer-parsing-numa-test.mtx").string();
+    TempFiles temp{ { path } };
+    generate_matrix_file(path, 5000);
+    MappedFile file(path);
+    if (!file.ok()) {
+        return fail("could not read " + path);
+    }
+    ParsedFile expected = parse_parallel(file.begin(), file.end(), 1, parse_custom_buf);
+
+    // the same node twice works just like two nodes, as far as the result is concerned
+    std::vector<int> two_nodes = { nodes.front(), nodes.back() };
+    for (size_t n_threads : { 1, 3 }) {
+        for (bool copy_input : { false, true }) {
+            ParsedFile actual = merge_parts(parse_parallel_numa(file.begin(), file.end(), n_threads, parse_simd_buf, 
+                                                                two_nodes, copy_input), 1);
+            bool same = actual.stats == expected.stats && actual.entries.size() == expected.entries.size() &&
+                        std::equal(actual.entries.begin(), actual.entries.end(), expected.entries.begin(), 
+                                   [] (Entry a, Entry b) { return a.row == b.row && a.col == b.col; });
+            if (!same) {
+                return fail("different result with " + std::to_string(n_threads) + " threads" 
+                            + (copy_input ? " and copied input" : ""));
+            }
+        }
+    }
+
+    std::cerr << "TEST PASSED: numa\n";
+}
+#endif
+#ifdef HAVE_ZLIB
+void test_gzip() {
+    auto fail = [] (const std::string& reason) {
+        std::cerr << "TEST FAILED: gzip\n";
+        std::cerr << "    " << reason << "\n";
+    };
+
+    auto temp = std::filesystem::temp_directory_path();
+    std::string text_path = (temp / "integer-parsing-gzip-test.mtx").string();
+    std::string bgzf_path = text_path + ".gz";
+    std::string gzip_path = (temp / "integer-parsing-gzip-test-plain.mtx.gz").string();
+    TempFiles temp_files{ { text_path, bgzf_path, gzip_path } };
+    generate_matrix_file(text_path, 20'000);
+    std::string text = read_file(text_path);
+
+    if (!write_bgzf(bgzf_path, text.data(), text.size())) {
+        return fail("could not write " + bgzf_path);
+    }
+
+    // plain gzip with two members, as `cat a.gz b.gz` would give, that one can't be split up front
+    size_t half = text.size()/2;
+    for (const char* mode : { "wb", "ab" }) {
+        gzFile gz = gzopen(gzip_path.c_str(), mode);
+        bool first = mode[0] == 'w';
+        gzwrite(gz, text.data() + (first ? 0 : half), static_cast<unsigned>(first ? half : text.size() - half));
+        gzclose(gz);
+    }
+
+    for (const auto& path : { bgzf_path, gzip_path }) {
+        MappedFile file(path);
+        if (!file.ok()) {
+            return fail("could not read " + path);
+        }
+
+        std::vector<GzipMember> members;
+        bool is_bgzf = find_bgzf_members(file.begin(), file.end(), members);
+        if (is_bgzf != (path == bgzf_path) || (is_bgzf && members.size() < 3)) {
+            return fail("wrong members found in " + path);
+        }
+
+        for (size_t n_threads : { 1, 3 }) {
+            std::vector<char> out;
+            if (!decompress_gzip(file.begin(), file.end(), n_threads, out) || std::string(out.begin(), out.end()) != text) {
+                return fail("wrong output for " + path + " with " + std::to_string(n_threads) + " threads");
+            }
+        }
+
+        // cut off in the middle of a member
+        std::vector<char> out;
+        if (decompress_gzip(file.begin(), file.end() - 100, 3, out)) {
+            return fail("truncated " + path + " accepted");
+        }
+    }
+
+    // a member claiming to decompress to 4 GiB is not taken as BGZF, and zlib rejects the wrong size
+    std::string corrupt = read_file(bgzf_path);
+    memset(&corrupt[corrupt.size() - 4], 0xff, 4);
+    std::vector<GzipMember> members;
+    std::vector<char> out;
+    if (find_bgzf_members(corrupt.data(), corrupt.data() + corrupt.size(), members)
+            || decompress_gzip(corrupt.data(), corrupt.data() + corrupt.size(), 3, out)) {
+        return fail("member with a wrong output size accepted");
+    }
+
+    std::cerr << "TEST PASSED: gzip\n";
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                BENCHMARKS                                      //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+
+// Turns on everything we want from nanobench for all the benchmarks.
+ankerl::nanobench::Bench make_bench() {
+    ankerl::nanobench::Bench bench;
+    // only available on linux, there nanobench reads the hardware counters through perf_event_open
+    bench.performanceCounters(true);
+    return bench;
+}
+
+// Metrics derived from the hardware performance counters, they tell whether a kernel is bound by
+// branch mispredictions or by throughput. `bytes` and `lines` are parsed in a single iteration.
+// Note that the counters only see the thread that runs the benchmark.
+void print_counters(const ankerl::nanobench::Bench& bench, double bytes, double lines) {
+    using Measure = ankerl::nanobench::Result::Measure;
+
+    bool any = false;
+    for (const auto& res : bench.results()) {
+        any = any || (res.has(Measure::instructions) && res.has(Measure::cpucycles));
+    }
+    if (!any) {
+        std::cout << "\nPerformance counters are not available, no derived metrics.\n";
+        return;
+    }
+
+    std::cout << "\n|         IPC |     ins/byte |     ins/line | branch misses/line | benchmark\n";
+    std::cout << "|------------:|-------------:|-------------:|-------------------:|:----------\n";
+    for (const auto& res : bench.results()) {
+        double ins = res.has(Measure::instructions) ? res.median(Measure::instructions) : 0;
+        double cycles = res.has(Measure::cpucycles) ? res.median(Measure::cpucycles) : 0;
+        double misses = res.has(Measure::branchmisses) ? res.median(Measure::branchmisses) : 0;
+
+        char row[160];
+        snprintf(row, sizeof(row), "| %11.2f | %12.2f | %12.2f | %18.4f | `%s`\n", 
+                 cycles > 0 ? ins/cycles : 0.0, ins/bytes, ins/lines, misses/lines, 
+                 res.config().mBenchmarkName.c_str());
+        std::cout << row;
+    }
+}
+
+// nanobench reports time per line, this adds the numbers we actually care about for the whole file
+void print_throughput(const ankerl::nanobench::Bench& bench, const FileInfo& info) {
+    std::cout << "\n|              lines/s |        MB/s |    GB/s | benchmark\n";
+    std::cout << "|---------------------:|------------:|--------:|:----------\n";
+    for (const auto& res : bench.results()) {
+        double seconds = res.median(ankerl::nanobench::Result::Measure::elapsed);
+        char row[128];
+        snprintf(row, sizeof(row), "| %20.0f | %11.2f | %7.3f | `%s`\n", 
+                 info.lines/seconds, info.bytes/seconds/1e6, info.bytes/seconds/1e9, 
+                 res.config().mBenchmarkName.c_str());
+        std::cout << row;
+    }
+
+    print_counters(bench, info.bytes, info.lines);
+}
+
+// Pins the calling thread to `core`, the threads it starts afterwards inherit that on linux. Set with
+// --pin, so the scheduler does not move the benchmark between cores in the middle of a measurement.
+bool pin_to_core(unsigned core) {
+#if defined(_WIN32)
+    return core < 64 && SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+    if (core >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+// Writes to every cache line of a buffer larger than the last level cache of anything I run this on,
+// so whatever the previous epoch left in the caches (the input, the lookup tables, the code) is gone.
+void evict_caches() {
+    static std::vector<char> buffer(64 << 20);
+    for (size_t i = 0; i < buffer.size(); i += 64) {
+        ++buffer[i];
+    }
+    ankerl::nanobench::doNotOptimizeAway(buffer.data());
+}
+
+// What a median hides: the first epoch (page faults, cold code and tables), the best case and the tail.
+struct EpochDistribution {
+    double first;
+    double min;
+    double median;
+    double p99;
+    double max;
+};
+
+EpochDistribution epoch_distribution(std::vector<double> epochs) {
+    EpochDistribution dist;
+    dist.first = epochs.front();
+    std::sort(epochs.begin(), epochs.end());
+    dist.min = epochs.front();
+    dist.median = epochs[epochs.size()/2];
+    dist.p99 = epochs[std::min(epochs.size() - 1, epochs.size()*99/100)];
+    dist.max = epochs.back();
+    return dist;
+}
+
+void print_distribution_header(const std::string& what) {
+    std::cout << "\n| " << what << "\n";
+    std::cout << "|  first ns/line |    min ns/line | median ns/line |    p99 ns/line |    max ns/line | benchmark\n";
+    std::cout << "|---------------:|---------------:|---------------:|---------------:|---------------:|:----------\n";
+}
+
+void print_distribution_row(const EpochDistribution& dist, double lines, const std::string& name) {
+    char row[256];
+    snprintf(row, sizeof(row), "| %14.2f | %14.2f | %14.2f | %14.2f | %14.2f | `%s`\n", dist.first*1e9/lines, 
+             dist.min*1e9/lines, dist.median*1e9/lines, dist.p99*1e9/lines, dist.max*1e9/lines, name.c_str());
+    std::cout << row;
+}
+
+// The same for the epochs nanobench measured, it keeps the time per iteration of every single one.
+void print_epochs(const ankerl::nanobench::Bench& bench) {
+    print_distribution_header(bench.title() + ", nanobench epochs");
+    for (const auto& res : bench.results()) {
+        std::vector<double> epochs;
+        for (size_t i = 0; i < res.size(); ++i) {
+            epochs.push_back(res.get(i, ankerl::nanobench::Result::Measure::elapsed));
+        }
+        print_distribution_row(epoch_distribution(epochs), res.config().mBatch, res.config().mBenchmarkName);
+    }
+}
+
+// Set with --export, all the results of the run are written into this directory at the end.
+std::string export_dir;
+std::vector<ankerl::nanobench::Result> collected_results;
+
+void collect_results(const ankerl::nanobench::Bench& bench) {
+    if (!export_dir.empty()) {
+        collected_results.insert(collected_results.end(), bench.results().begin(), bench.results().end());
+    }
+}
+
+// The flags are passed in by cmake, see CMakeLists.txt
+#ifndef BENCH_CXX_FLAGS
+    #define BENCH_CXX_FLAGS ""
+#endif
+#ifndef BENCH_BUILD_TYPE
+    #define BENCH_BUILD_TYPE ""
+#endif
+
+std::string compiler_name() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+std::string compiler_flags() {
+    std::string flags = BENCH_BUILD_TYPE;
+    flags += " ";
+    flags += BENCH_CXX_FLAGS;
+    return flags;
+}
+
+// The brand string, e.g. "Intel(R) Core(TM) i7-7700HQ CPU @ 2.80GHz"
+std::string cpu_name() {
+    std::string name;
+#if defined(HAVE_X86_SIMD)
+    int info[4] = {};
+    for (unsigned leaf = 0x80000002; leaf <= 0x80000004; ++leaf) {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        __cpuid(info, leaf);
+    #else
+        unsigned regs[4];
+        __get_cpuid(leaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+        memcpy(info, regs, sizeof(info));
+    #endif
+        name.append(reinterpret_cast<const char*>(info), sizeof(info));
+    }
+    name.resize(strnlen(name.c_str(), name.size()));
+#endif
+    // the brand string is padded with spaces
+    name.erase(0, name.find_first_not_of(' '));
+    name.erase(name.find_last_not_of(' ') + 1);
+    return name.empty() ? "unknown" : name;
+}
+
+// The values end up inside quoted strings of the templates.
+std::string escape(const std::string& str) {
+    std::string res;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res;
+}
+
+// Writes `<dir>/<mode>-<compiler>.csv` and `.json`. The csv has one line per contender which is all the
+// compare mode needs, the json contains every measurement nanobench made. Both are tagged with the
+// compiler, the flags and the cpu, so results from different builds can be told apart.
+bool export_results(const std::string& mode) {
+    std::string compiler = compiler_name();
+    std::string flags = compiler_flags();
+    std::string cpu = cpu_name();
+
+    std::string tag = compiler;
+    std::replace_if(tag.begin(), tag.end(), [](char c) { return !isalnum(c) && c != '.'; }, '-');
+    std::filesystem::create_directories(export_dir);
+    auto base = std::filesystem::path(export_dir) / (mode + "-" + tag);
+
+    std::string build_info = "\"" + escape(compiler) + "\";\"" + escape(flags) + "\";\"" + escape(cpu) + "\";";
+    std::string csv =
+        "\"compiler\";\"flags\";\"cpu\";\"title\";\"name\";\"unit\";\"batch\";\"elapsed\";\"error %\";"
+        "\"instructions\";\"branches\";\"branch misses\"\n"
+        "{{#result}}" + build_info + "\"{{title}}\";\"{{name}}\";\"{{unit}}\";{{batch}};{{median(elapsed)}};"
+        "{{medianAbsolutePercentError(elapsed)}};{{median(instructions)}};{{median(branchinstructions)}};"
+        "{{median(branchmisses)}}\n{{/result}}";
+
+    // the json template is a single object, the build info goes in front of its "results"
+    std::string json = ankerl::nanobench::templates::json();
+    json.insert(json.find('{') + 1, "\n    \"compiler\": \"" + escape(compiler) + "\",\n    \"flags\": \"" 
+                + escape(flags) + "\",\n    \"cpu\": \"" + escape(cpu) + "\",");
+
+    for (const auto& [ext, tmpl] : { std::make_pair(".csv", &csv), std::make_pair(".json", &json) }) {
+        std::string path = base.string() + ext;
+        std::ofstream out(path);
+        ankerl::nanobench::render(*tmpl, collected_results, out);
+        if (!out) {
+            std::cerr << "Could not write " << path << "\n";
+            return false;
+        }
+        std::cerr << "Results written to " << path << "\n";
+    }
+#ifdef BENCH_STAGE_STATS
+    std::string path = base.string() + "-stages.csv";
+    if (!write_stage_stats(path)) {
+        std::cerr << "Could not write " << path << "\n";
+        return false;
+    }
+    std::cerr << "Results written to " << path << "\n";
+#endif
+    return true;
+}
+
+struct ExportedResult {
+    std::string title;
+    std::string name;
+    double ns_per_op;
+    double err;
+};
+
+// Splits a line of the csv written above, the strings are quoted and may contain escaped quotes.
+std::vector<std::string> split_csv_line(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted && c == '\\' && i + 1 < line.size()) {
+            fields.back() += line[++i];
+        } else if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ';' && !quoted) {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+bool read_exported_results(const std::string& path, std::vector<ExportedResult>& results) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line)) {
+        std::cerr << "Could not read " << path << "\n";
+        return false;
+    }
+
+    // look the columns up by name to not depend on their order
+    std::vector<std::string> header = split_csv_line(line);
+    auto column = [&](const char* name) {
+        return size_t(std::find(header.begin(), header.end(), name) - header.begin());
+    };
+    size_t title = column("title"), name = column("name"), batch = column("batch");
+    size_t elapsed = column("elapsed"), err = column("error %");
+    size_t needed = std::max({ title, name, batch, elapsed, err });
+    if (needed >= header.size()) {
+        std::cerr << path << " is not a result file written by --export\n";
+        return false;
+    }
+
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields = split_csv_line(line);
+        if (fields.size() <= needed) {
+            continue;
+        }
+        double per_op = std::stod(fields[elapsed]) / std::stod(fields[batch]);
+        results.push_back({ fields[title], fields[name], per_op * 1e9, std::stod(fields[err]) });
+    }
+    return true;
+}
+
+// A contender regressed if its median got slower by more than the error of either of the measurements,
+// anything within that is just noise. Returns false if there was a regression.
+bool compare_results(const std::string& baseline_path, const std::string& current_path) {
+    std::vector<ExportedResult> baseline, current;
+    if (!read_exported_results(baseline_path, baseline) || !read_exported_results(current_path, current)) {
+        return false;
+    }
+
+    size_t regressions = 0;
+    std::cout << "\n| baseline ns/op |  current ns/op |  change |    err% | status     | benchmark\n";
+    std::cout << "|---------------:|---------------:|--------:|--------:|:-----------|:----------\n";
+    for (const auto& cur : current) {
+        auto base = std::find_if(baseline.begin(), baseline.end(), [&](const ExportedResult& r) {
+            return r.title == cur.title && r.name == cur.name;
+        });
+        if (base == baseline.end()) {
+            continue;
+        }
+
+        double change = cur.ns_per_op / base->ns_per_op - 1;
+        double err = std::max(base->err, cur.err);
+        const char* status = change > err ? "REGRESSED" : change < -err ? "improved" : "same";
+        regressions += change > err;
+
+        char row[256];
+        snprintf(row, sizeof(row), "| %14.2f | %14.2f | %6.1f%% | %6.1f%% | %-10s | `%s` `%s`\n", 
+                 base->ns_per_op, cur.ns_per_op, change * 100, err * 100, status, cur.title.c_str(), cur.name.c_str());
+        std::cout << row;
+    }
+
+    std::cout << "\n" << regressions << " regression(s)\n";
+    return regressions == 0;
+}
+
+// If no path (or "-") is given a file with `entries` lines is generated into the temp directory.
+std::string prepare_file(std::string path, size_t entries) {
+    if (path.empty() || path == "-") {
+        path = (std::filesystem::temp_directory_path() / "integer-parsing.mtx").string();
+        std::cerr << "Generating " << entries << " entries into " << path << "\n";
+        generate_matrix_file(path, entries);
+    }
+    return path;
+}
+
+// Benchmarks loading a whole file with each of the implementations.
+void run_file_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    FileInfo info = get_file_info(path);
+    if (info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    // all the implementations must agree on what is in the file
+    LoadStats expected = load_file(path, parse_from_chars);
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << expected << "\n\n";
+
+    auto check = [&] (auto func, const std::string& test_name) {
+        LoadStats actual = load_file(path, func);
+        if (!(actual == expected)) {
+            std::cerr << "FILE TEST FAILED: " << test_name << "\n";
+            std::cerr << "    Got:      " << actual << "\n";
+            std::cerr << "    Expected: " << expected << "\n";
+        }
+    };
+
+    check(parse_string_stream, "stringstream");
+    check(parse_sscanf, "sscanf");
+    check(parse_strtoull, "strtoull");
+    check(parse_custom, "custom");
+    check(parse_from_chars_lut, "from_chars lut");
+    check(parse_custom_lut, "custom lut");
+
+    // the buffer based implementations get the whole file in memory
+    std::string content = read_file(path);
+    const char* begin = content.data();
+    const char* end = content.data() + content.size();
+
+    auto check_buffer = [&] (auto func, const std::string& test_name) {
+        LoadStats actual = parse_buffer(begin, end, func);
+        if (!(actual == expected)) {
+            std::cerr << "FILE TEST FAILED: " << test_name << "\n";
+            std::cerr << "    Got:      " << actual << "\n";
+            std::cerr << "    Expected: " << expected << "\n";
+        }
+    };
+
+    check_buffer(parse_string_stream_buf, "stringstream buffer");
+    check_buffer(parse_sscanf_buf, "sscanf buffer");
+    check_buffer(parse_strtoull_buf, "strtoull buffer");
+    check_buffer(parse_from_chars_buf, "from_chars buffer");
+    check_buffer(parse_custom_buf, "custom buffer");
+    check_buffer(parse_swar_buf, "swar buffer");
+    check_buffer(parse_custom_skip_buf, "custom skip buffer");
+    check_buffer(parse_swar_skip_buf, "swar skip buffer");
+    check_buffer(parse_simd_buf, "simd buffer");
+    check_buffer(parse_typed_buf<uint32_t>, "fields<uint32_t, 2>");
+    check_buffer(parse_typed_buf<uint64_t>, "fields<uint64_t, 2>");
+
+    auto check_stats = [&] (const LoadStats& actual, const std::string& test_name) {
+        if (!(actual == expected)) {
+            std::cerr << "FILE TEST FAILED: " << test_name << "\n";
+            std::cerr << "    Got:      " << actual << "\n";
+            std::cerr << "    Expected: " << expected << "\n";
+        }
+    };
+    check_stats(parse_buffer_batched<parse_swar_buf>(begin, end), "swar batch");
+    check_stats(parse_buffer_batched<parse_simd_buf>(begin, end), "simd batch");
+
+    // every entry in the generated file has a value, so they all must be found
+    double value_sum;
+    if (!(parse_buffer_values(begin, end, value_sum) == expected)) {
+        std::cerr << "FILE TEST FAILED: swar skip buffer + value\n";
+    }
+
+    auto bench = make_bench();
+
+    // one epoch is a whole file so there is no need for many of them
+    bench.title("whole file").unit("line").batch(info.lines).epochs(5);
+
+    bench
+        .run("stringstream", [&] {
+            auto stats = load_file(path, parse_string_stream);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("sscanf", [&] {
+            auto stats = load_file(path, parse_sscanf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("strtoull", [&] {
+            auto stats = load_file(path, parse_strtoull);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("from_chars", [&] {
+            auto stats = load_file(path, parse_from_chars);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("custom", [&] {
+            auto stats = load_file(path, parse_custom);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("from_chars lut", [&] {
+            auto stats = load_file(path, parse_from_chars_lut);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("custom lut", [&] {
+            auto stats = load_file(path, parse_custom_lut);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("stringstream buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_string_stream_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("sscanf buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_sscanf_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("strtoull buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_strtoull_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("from_chars buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_from_chars_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("custom buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_custom_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("swar buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_swar_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("custom skip buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_custom_skip_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("swar skip buffer", [&] {
+            auto stats = parse_buffer(begin, end, parse_swar_skip_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run(std::string("simd buffer (") + simd_kernel.name + ")", [&] {
+            auto stats = parse_buffer(begin, end, parse_simd_buf);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("fields<uint32_t, 2>", [&] {
+            auto stats = parse_buffer(begin, end, parse_typed_buf<uint32_t>);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("fields<uint64_t, 2>", [&] {
+            auto stats = parse_buffer(begin, end, parse_typed_buf<uint64_t>);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("swar batch", [&] {
+            auto stats = parse_buffer_batched<parse_swar_buf>(begin, end);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("simd batch", [&] {
+            auto stats = parse_buffer_batched<parse_simd_buf>(begin, end);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("swar skip buffer + value", [&] {
+            double sum;
+            auto stats = parse_buffer_values(begin, end, sum);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+            ankerl::nanobench::doNotOptimizeAway(sum);
+        });
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// Compares the ways of getting the file into memory, everything is parsed by the custom implementation.
+void run_io_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    FileInfo info = get_file_info(path);
+    if (info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    LoadStats expected = load_file(path, parse_custom);
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << expected << "\n\n";
+
+    if (!(load_file_fread(path) == expected)) {
+        std::cerr << "FILE TEST FAILED: fread\n";
+    }
+    if (!(load_file_mmap(path) == expected)) {
+        std::cerr << "FILE TEST FAILED: mmap\n";
+    }
+
+    auto bench = make_bench();
+    bench.title("file reading").unit("line").batch(info.lines).epochs(5);
+
+    bench
+        .run("ifstream + getline", [&] {
+            auto stats = load_file(path, parse_custom);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("fread", [&] {
+            auto stats = load_file_fread(path);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        })
+        .run("mmap", [&] {
+            auto stats = load_file_mmap(path);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        });
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// Shows how the parallel loader scales with the number of threads, everything is parsed by the simd kernel.
+void run_threads_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    ParsedFile expected = parse_parallel(file.begin(), file.end(), 1, parse_simd_buf);
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << expected.stats << "\n\n";
+
+    for (size_t n = 2; n <= max_threads; ++n) {
+        ParsedFile actual = parse_parallel(file.begin(), file.end(), n, parse_simd_buf);
+        bool same = actual.stats == expected.stats && actual.entries.size() == expected.entries.size() &&
+                    std::equal(actual.entries.begin(), actual.entries.end(), expected.entries.begin(), 
+                               [] (Entry a, Entry b) { return a.row == b.row && a.col == b.col; });
+        if (!same) {
+            std::cerr << "FILE TEST FAILED: " << n << " threads\n";
+            std::cerr << "    Got:      " << actual.stats << "\n";
+            std::cerr << "    Expected: " << expected.stats << "\n";
+        }
+    }
+
+    auto bench = make_bench();
+    bench.title("threads").unit("line").batch(info.lines).epochs(5).relative(true);
+
+    for (size_t n = 1; n <= max_threads; ++n) {
+        bench.run(std::to_string(n) + (n == 1 ? " thread" : " threads"), [&] {
+            auto parsed = parse_parallel(file.begin(), file.end(), n, parse_simd_buf);
+            ankerl::nanobench::doNotOptimizeAway(parsed);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// Equally sized chunks against work stealing on a file where some parts are a lot slower than others.
+// Without a path a deliberately skewed file is generated.
+void run_steal_benchmark(std::string path, size_t entries) {
+    TempFiles generated;
+    if (path.empty() || path == "-") {
+        path = (std::filesystem::temp_directory_path() / "integer-parsing-skewed.mtx").string();
+        generated.paths.push_back(path);
+        std::cerr << "Generating " << entries << " skewed entries into " << path << "\n";
+        generate_skewed_file(path, entries);
+    }
+
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    // with a single core there is nothing to balance, but at least the scheduling overhead shows
+    const size_t n_threads = std::max(4u, std::thread::hardware_concurrency());
+    const std::string threads = std::to_string(n_threads) + " threads";
+
+    using Loader = std::function<ParsedFile(std::vector<double>*)>;
+    std::vector<std::pair<std::string, Loader>> contenders = {
+        { "static, " + threads, [&] (std::vector<double>* busy) {
+            return parse_parallel(file.begin(), file.end(), n_threads, parse_simd_buf, busy);
+        } },
+    };
+    for (size_t task_kib : { 16, 64, 256 }) {
+        contenders.emplace_back("stealing " + std::to_string(task_kib) + " KiB tasks, " + threads, 
+                                [&, task_kib] (std::vector<double>* busy) {
+            return parse_work_stealing(file.begin(), file.end(), n_threads, parse_simd_buf, task_kib << 10, busy);
+        });
+    }
+
+    ParsedFile expected = parse_parallel(file.begin(), file.end(), 1, parse_simd_buf);
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << expected.stats << "\n\n";
+
+    // how long the threads were busy in a single run, the slowest one is the tail everyone waits for
+    std::cout << "| mean thread ms | slowest thread ms | slowest/mean | benchmark\n";
+    std::cout << "|---------------:|------------------:|-------------:|:----------\n";
+    for (const auto& [name, load] : contenders) {
+        std::vector<double> busy;
+        ParsedFile actual = load(&busy);
+        if (!(actual.stats == expected.stats) || actual.entries.size() != expected.entries.size()) {
+            std::cerr << "Different result from " << name << ": " << actual.stats << "\n";
+        }
+
+        double mean = std::accumulate(busy.begin(), busy.end(), 0.0) / busy.size();
+        double slowest = *std::max_element(busy.begin(), busy.end());
+        char row[160];
+        snprintf(row, sizeof(row), "| %14.2f | %17.2f | %12.2f | `%s`\n", mean*1e3, slowest*1e3, slowest/mean, name.c_str());
+        std::cout << row;
+    }
+    std::cout << "\n";
+
+    auto bench = make_bench();
+    bench.title("work stealing").unit("line").batch(info.lines).epochs(5).relative(true);
+    for (const auto& [name, load] : contenders) {
+        bench.run(name, [&] {
+            auto parsed = load(nullptr);
+            ankerl::nanobench::doNotOptimizeAway(parsed);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// Compares collecting a `Result` per line with the structure of arrays output.
+void run_output_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    std::vector<Result> results = load_results(file.begin(), file.end(), parse_simd_buf);
+    ParsedFile parsed = parse_parallel(file.begin(), file.end(), 1, parse_simd_buf);
+    IndexArrays<uint32_t> arrays32;
+    load_index_arrays(file.begin(), file.end(), parse_simd_buf, arrays32);
+    IndexArrays<uint64_t> arrays64;
+    load_index_arrays(file.begin(), file.end(), parse_simd_buf, arrays64);
+    AnyIndexArrays arrays;
+    if (!load_index_arrays(file.begin(), file.end(), parse_simd_buf, arrays)) {
+        std::cerr << "Invalid size line in: " << path << "\n";
+        return;
+    }
+
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << parsed.stats << "\n";
+    std::cerr << "    " << (arrays.index() == 0 ? "32" : "64") << "-bit indices picked from the size line\n";
+    if (arrays64.rows.size() != parsed.entries.size() || arrays64.errors.size() != parsed.stats.errors) {
+        std::cerr << "FILE TEST FAILED: index arrays\n";
+    }
+    for (size_t i = 0; i < std::min<size_t>(arrays64.errors.size(), 10); ++i) {
+        std::cerr << "    error on line " << arrays64.errors[i].line << "\n";
+    }
+    std::cerr << "\n";
+
+    auto bench = make_bench();
+    bench.title("output").unit("line").batch(info.lines).epochs(5);
+
+    bench
+        .run("vector<Result>", [&] {
+            auto res = load_results(file.begin(), file.end(), parse_simd_buf);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("vector<Entry>", [&] {
+            auto res = parse_parallel(file.begin(), file.end(), 1, parse_simd_buf);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("arrays uint64_t", [&] {
+            IndexArrays<uint64_t> res;
+            load_index_arrays(file.begin(), file.end(), parse_simd_buf, res);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("arrays uint32_t", [&] {
+            IndexArrays<uint32_t> res;
+            load_index_arrays(file.begin(), file.end(), parse_simd_buf, res);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("arrays from size line", [&] {
+            AnyIndexArrays res;
+            load_index_arrays(file.begin(), file.end(), parse_simd_buf, res);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+
+    print_throughput(bench, info);
+    collect_results(bench);
+
+    size_t arrays_bytes = std::visit([] (const auto& a) { return a.bytes(); }, arrays);
+    std::cout << "\n|                bytes |  bytes/entry | output\n";
+    std::cout << "|---------------------:|-------------:|:----------\n";
+    auto print_memory = [&] (const char* name, size_t bytes) {
+        char row[128];
+        snprintf(row, sizeof(row), "| %20zu | %12.2f | `%s`\n", bytes, double(bytes)/parsed.stats.entries, name);
+        std::cout << row;
+    };
+    print_memory("vector<Result>", results.capacity()*sizeof(Result));
+    print_memory("vector<Entry>", parsed.entries.capacity()*sizeof(Entry));
+    print_memory("arrays uint64_t", arrays64.bytes());
+    print_memory("arrays uint32_t", arrays32.bytes());
+    print_memory("arrays from size line", arrays_bytes);
+}
+
+// Compares the index arrays which grow as they go with the ones allocated based on the header.
+void run_header_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    MatrixMarket<uint32_t> matrix;
+    if (!load_matrix_market(file.begin(), file.end(), parse_simd_buf, matrix)) {
+        std::cerr << "Not a coordinate matrix with 32-bit dimensions: " << path << "\n";
+        return;
+    }
+
+    const MatrixMarketHeader& header = matrix.header;
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << header.object << " " << header.format << " " << header.field << " " << header.symmetry << ", "
+              << header.size.rows << " x " << header.size.cols << ", " << header.size.nnz << " entries\n";
+    std::cerr << "    " << matrix.arrays.rows.size() << " entries, " << matrix.arrays.empty << " empty, " 
+              << matrix.arrays.errors.size() << " errors\n";
+    if (matrix.arrays.rows.size() != header.size.nnz) {
+        std::cerr << "    the number of entries does not match the size line\n";
+    }
+    std::cerr << "\n";
+
+    auto bench = make_bench();
+    bench.title("header").unit("line").batch(info.lines).epochs(5);
+
+    bench
+        .run("growing arrays", [&] {
+            IndexArrays<uint32_t> res;
+            load_index_arrays(file.begin(), file.end(), parse_simd_buf, res);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("pre-sized and validated", [&] {
+            MatrixMarket<uint32_t> res;
+            load_matrix_market(file.begin(), file.end(), parse_simd_buf, res);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// The optimistic loader against the one which counts the lines as it goes, once on a clean file and
+// once with one in a thousand entries broken, which is already a lot worse than anything I've seen.
+void run_optimistic_benchmark(std::string path, size_t entries) {
+    std::vector<std::string> paths;
+    // the broken file is generated on every run, so it is removed at the end
+    TempFiles generated;
+    if (path.empty() || path == "-") {
+        paths.push_back(prepare_file(path, entries));
+        paths.push_back((std::filesystem::temp_directory_path() / "integer-parsing-bad.mtx").string());
+        generated.paths.push_back(paths.back());
+        std::cerr << "Generating " << entries << " entries with 0.1% bad ones into " << paths.back() << "\n";
+        generate_matrix_file(paths.back(), entries, 1000);
+    } else {
+        paths.push_back(path);
+    }
+
+    for (const auto& file_path : paths) {
+        MappedFile file(file_path);
+        FileInfo info = get_file_info(file_path);
+        if (!file.ok() || info.lines == 0) {
+            std::cerr << "Could not read file: " << file_path << "\n";
+            return;
+        }
+
+        IndexArrays<uint32_t> expected;
+        load_index_arrays(file.begin(), file.end(), parse_simd_buf, expected);
+        IndexArrays<uint32_t> actual;
+        std::vector<LineDiagnostic> diagnostics;
+        load_index_arrays_optimistic(file.begin(), file.end(), parse_simd_buf, actual, diagnostics);
+
+        std::cerr << "File: " << file_path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+        std::cerr << "    " << actual.rows.size() << " entries, " << actual.empty << " empty, " 
+                  << actual.errors.size() << " errors\n";
+        for (size_t i = 0; i < std::min<size_t>(3, diagnostics.size()); ++i) {
+            std::cerr << "    " << file_path << ":" << diagnostics[i].line << ":" << diagnostics[i].column 
+                      << ": " << diagnostics[i].reason << "\n";
+        }
+        if (actual.rows != expected.rows || actual.cols != expected.cols || actual.errors.size() != expected.errors.size()) {
+            std::cerr << "    the optimistic loader does not agree with load_index_arrays\n";
+        }
+        std::cerr << "\n";
+
+        auto bench = make_bench();
+        bench.title(std::filesystem::path(file_path).filename().string()).unit("line").batch(info.lines).epochs(5);
+
+        bench
+            .run("counting lines", [&] {
+                IndexArrays<uint32_t> res;
+                load_index_arrays(file.begin(), file.end(), parse_simd_buf, res);
+                ankerl::nanobench::doNotOptimizeAway(res);
+            })
+            .run("optimistic", [&] {
+                IndexArrays<uint32_t> res;
+                std::vector<LineDiagnostic> diag;
+                load_index_arrays_optimistic(file.begin(), file.end(), parse_simd_buf, res, diag);
+                ankerl::nanobench::doNotOptimizeAway(res);
+            });
+
+        print_throughput(bench, info);
+        collect_results(bench);
+    }
+}
+
+// How the generated lines look like.
+struct LineDistribution {
+    std::string name;
+    // number of digits of every index, 0 means anything from 1 to 20
+    unsigned digits;
+    std::string separator;
+    // how many percent of the lines are blank or invalid, half of each
+    int bad_percent;
+};
+
+std::vector<std::string> generate_lines(const LineDistribution& dist, size_t count) {
+    std::uniform_int_distribution<unsigned> digits_dist(1, 20);
+    std::uniform_int_distribution<int> percent_dist(0, 99);
+    // a bad line is one of two blank and two invalid ones, drawn apart from whether it is bad at all
+    std::uniform_int_distribution<int> bad_dist(0, 3);
+
+    auto random_index = [&] () {
+        unsigned digits = dist.digits == 0 ? digits_dist(mt) : dist.digits;
+        uint64_t lo = 1;
+        for (unsigned i = 1; i < digits; ++i) {
+            lo *= 10;
+        }
+        // the 20-digit ones have to stay below the maximum
+        uint64_t hi = digits == 20 ? uint64_t(-1) : 10*lo - 1;
+        return std::uniform_int_distribution<uint64_t>(lo, hi)(mt);
+    };
+
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (percent_dist(mt) < dist.bad_percent) {
+            static const char* const bad_lines[] = { "", "  \t ", "12 x 1.5", "k 12 13" };
+            lines.push_back(bad_lines[bad_dist(mt)]);
+        } else {
+            lines.push_back(std::to_string(random_index()) + dist.separator + std::to_string(random_index()) +
+                            dist.separator + "25.01564");
+        }
+    }
+
+    return lines;
+}
+
+// Even with 1 % bad lines both the blank and the invalid ones have to show up, otherwise the
+// distributions don't measure the error path they are named after.
+void test_generate_lines() {
+    LineDistribution dist = { "1% bad lines", 0, " ", 1 };
+    LoadStats stats;
+    for (const auto& line : generate_lines(dist, 10'000)) {
+        add_result(stats, parse_from_chars(line));
+    }
+    // about 50 of each
+    if (stats.empty < 10 || stats.errors < 10 || stats.empty + stats.errors > 300) {
+        std::cerr << "TEST FAILED: generated lines\n";
+        std::cerr << "    " << stats.empty << " blank and " << stats.errors << " invalid lines out of 10000\n";
+        return;
+    }
+    std::cerr << "TEST PASSED: generated lines\n";
+}
+
+// Compares streaming the file through a fixed buffer with reading all of it and collecting the entries.
+// Besides the throughput also reports how much the peak resident set size grows during a single load.
+void run_stream_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    FileInfo info = get_file_info(path);
+    if (info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    // the streamed entries only go into a checksum, the whole point is not to keep them around
+    auto stream = [&] (size_t buffer_size) {
+        return [&path, buffer_size] {
+            LoadStats stats;
+            size_t sum = 0;
+            stream_file(path, buffer_size, parse_simd_buf, [&] (const Entry* entries, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    sum += entries[i].row ^ entries[i].col;
+                }
+            }, stats);
+            ankerl::nanobench::doNotOptimizeAway(sum);
+            return stats;
+        };
+    };
+
+    std::vector<std::pair<std::string, std::function<LoadStats()>>> contenders = {
+        { "stream 64 KiB", stream(64 << 10) },
+        { "stream 1 MiB", stream(1 << 20) },
+        { "stream 16 MiB", stream(16 << 20) },
+        { "fread + vector<Entry>", [&] {
+            std::vector<char> buffer = fread_file(path);
+            ParsedFile parsed = parse_parallel(buffer.data(), buffer.data() + buffer.size(), 1, parse_simd_buf);
+            ankerl::nanobench::doNotOptimizeAway(parsed.entries.data());
+            return parsed.stats;
+        } },
+        { "mmap + vector<Entry>", [&] {
+            MappedFile file(path);
+            ParsedFile parsed = parse_parallel(file.begin(), file.end(), 1, parse_simd_buf);
+            ankerl::nanobench::doNotOptimizeAway(parsed.entries.data());
+            return parsed.stats;
+        } },
+    };
+
+    // before the benchmark so the memory left over from the other runs does not hide anything
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n\n";
+    std::cout << "|   peak RSS growth | benchmark\n";
+    std::cout << "|------------------:|:----------\n";
+    LoadStats expected = contenders.back().second();
+    for (const auto& [name, load] : contenders) {
+        reset_peak_rss();
+        size_t before = peak_rss();
+        LoadStats stats = load();
+        size_t after = peak_rss();
+        if (!(stats == expected)) {
+            std::cerr << "Different result from " << name << ": " << stats << "\n";
+        }
+
+        char row[128];
+        if (after == 0) {
+            snprintf(row, sizeof(row), "| %17s | `%s`\n", "n/a", name.c_str());
+        } else {
+            snprintf(row, sizeof(row), "| %14.1f MB | `%s`\n", (after - before)/1e6, name.c_str());
+        }
+        std::cout << row;
+    }
+
+    auto bench = make_bench();
+    bench.title("stream").unit("line").batch(info.lines).epochs(5);
+    for (const auto& [name, load] : contenders) {
+        bench.run(name, [&] {
+            auto res = load();
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// Sequential loaders against the pipelined ones. The interesting numbers are the cold ones, where the
+// file is dropped from the page cache before every load and the reads really have to wait for the disk.
+void run_pipeline_benchmark(std::string path, size_t entries) {
+    constexpr size_t cold_runs = 5;
+    path = prepare_file(path, entries);
+
+    FileInfo info = get_file_info(path);
+    if (info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    auto noop_sink = [] (const Entry*, size_t count) {
+        ankerl::nanobench::doNotOptimizeAway(count);
+    };
+    auto pipelined = [&] (size_t n_buffers) {
+        return [&path, &noop_sink, n_buffers] {
+            LoadStats stats;
+            stream_file_pipelined(path, 1 << 20, n_buffers, parse_simd_buf, noop_sink, stats);
+            return stats;
+        };
+    };
+
+    std::vector<std::pair<std::string, std::function<LoadStats()>>> contenders = {
+        { "fread, then parse", [&] {
+            std::vector<char> buffer = fread_file(path);
+            return parse_buffer(buffer.data(), buffer.data() + buffer.size(), parse_simd_buf);
+        } },
+        { "mmap", [&] {
+            MappedFile file(path);
+            return parse_buffer(file.begin(), file.end(), parse_simd_buf);
+        } },
+        { "stream 1 MiB", [&] {
+            LoadStats stats;
+            stream_file(path, 1 << 20, parse_simd_buf, noop_sink, stats);
+            return stats;
+        } },
+        { "pipelined 2 x 1 MiB", pipelined(2) },
+        { "pipelined 4 x 1 MiB", pipelined(4) },
+    };
+
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n\n";
+
+    LoadStats expected = contenders.front().second();
+    if (!evict_page_cache(path)) {
+        std::cerr << "Could not drop the file from the page cache, only measuring with a warm cache\n\n";
+    } else {
+        std::cout << "| cold median ms |   cold MB/s | cold min ms | benchmark\n";
+        std::cout << "|---------------:|------------:|------------:|:----------\n";
+        for (const auto& [name, load] : contenders) {
+            std::vector<double> times;
+            for (size_t i = 0; i < cold_runs; ++i) {
+                evict_page_cache(path);
+                auto start = std::chrono::steady_clock::now();
+                LoadStats stats = load();
+                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                if (!(stats == expected)) {
+                    std::cerr << "Different result from " << name << ": " << stats << "\n";
+                }
+            }
+            std::sort(times.begin(), times.end());
+            double median = times[times.size()/2];
+
+            char row[128];
+            snprintf(row, sizeof(row), "| %14.2f | %11.2f | %11.2f | `%s`\n", 
+                     median*1e3, info.bytes/median/1e6, times.front()*1e3, name.c_str());
+            std::cout << row;
+        }
+        std::cout << "\n";
+    }
+
+    auto bench = make_bench();
+    bench.title("pipeline (warm)").unit("line").batch(info.lines).epochs(5);
+    for (const auto& [name, load] : contenders) {
+        bench.run(name, [&] {
+            auto res = load();
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// The consumer could start as soon as the first entries are parsed. Compares parsing everything and
+// only then handing it over with the queue, once with a single producer (SPSC) and once with as many
+// as there are cores (MPSC), by how long it takes until the consumer sees the first entry and until
+// it is done. The consumer stands in for the graph builder and only sums the entries up.
+void run_queue_benchmark(std::string path, size_t entries) {
+    constexpr size_t runs = 5;
+    path = prepare_file(path, entries);
+
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    const size_t n_threads = std::max(2u, std::thread::hardware_concurrency());
+    const std::string threads = std::to_string(n_threads) + " threads";
+
+    // all of them call `consume(first, count)` and return the stats of the parsing
+    using Consumer = std::function<void(const Entry*, size_t)>;
+    using Loader = std::function<LoadStats(const Consumer&)>;
+    std::vector<std::pair<std::string, Loader>> contenders = {
+        { "parse everything, then consume, " + threads, [&] (const Consumer& consume) {
+            ParsedFile parsed = parse_parallel(file.begin(), file.end(), n_threads, parse_simd_buf);
+            consume(parsed.entries.data(), parsed.entries.size());
+            return parsed.stats;
+        } },
+        { "queue, 1 producer", [&] (const Consumer& consume) {
+            return parse_parallel_queued(file.begin(), file.end(), 1, parse_simd_buf, consume);
+        } },
+        { "queue, " + std::to_string(n_threads) + " producers", [&] (const Consumer& consume) {
+            return parse_parallel_queued(file.begin(), file.end(), n_threads, parse_simd_buf, consume);
+        } },
+    };
+
+    size_t sum = 0;
+    auto summing = [&sum] (const Entry* first, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            sum += first[i].row + first[i].col;
+        }
+    };
+
+    LoadStats expected = contenders.front().second(summing);
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << expected << "\n\n";
+
+    std::cout << "| first entry ms | total ms | benchmark\n";
+    std::cout << "|---------------:|---------:|:----------\n";
+    for (const auto& [name, load] : contenders) {
+        std::vector<double> first_times, total_times;
+        for (size_t i = 0; i < runs; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            double first = -1;
+            sum = 0;
+            LoadStats stats = load([&] (const Entry* entries, size_t count) {
+                if (first < 0) {
+                    first = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                }
+                summing(entries, count);
+            });
+            total_times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            first_times.push_back(first);
+            if (!(stats == expected) || sum != expected.checksum) {
+                std::cerr << "Different result from " << name << ": " << stats << "\n";
+            }
+        }
+        std::sort(first_times.begin(), first_times.end());
+        std::sort(total_times.begin(), total_times.end());
+
+        char row[256];
+        snprintf(row, sizeof(row), "| %14.3f | %8.2f | `%s`\n", 
+                 first_times[runs/2]*1e3, total_times[runs/2]*1e3, name.c_str());
+        std::cout << row;
+    }
+    std::cout << "\n";
+
+    auto bench = make_bench();
+    bench.title("queue").unit("line").batch(info.lines).epochs(5);
+    for (const auto& [name, load] : contenders) {
+        bench.run(name, [&] {
+            auto res = load(summing);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+    ankerl::nanobench::doNotOptimizeAway(sum);
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// The numa aware loader against parse_parallel_parts(), which lets the scheduler put the threads anywhere,
+// with the threads spread over 1 and 2 nodes. The parts are not merged in either, merging would copy
+// everything into memory of a single node again.
+void run_numa_benchmark(std::string path, size_t entries) {
+#ifndef HAVE_NUMA
+    (void)path;
+    (void)entries;
+    std::cerr << "Built without libnuma, the numa mode is not available\n";
+#else
+    std::vector<int> nodes = numa_cpu_nodes();
+    if (nodes.empty()) {
+        std::cerr << "No numa support on this system\n";
+        return;
+    }
+
+    path = prepare_file(path, entries);
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    const size_t n_threads = std::max(2u, std::thread::hardware_concurrency());
+    const std::string threads = std::to_string(n_threads) + " threads";
+
+    auto stats_of = [] (const std::vector<ParsedFile>& parts) {
+        LoadStats stats;
+        for (const auto& part : parts) {
+            merge_stats(stats, part.stats);
+        }
+        return stats;
+    };
+
+    LoadStats expected = stats_of(parse_parallel_parts(file.begin(), file.end(), n_threads, parse_simd_buf));
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << expected << "\n";
+    std::cerr << "    " << nodes.size() << " numa node(s) with cpus, " << threads << "\n\n";
+
+    auto bench = make_bench();
+    bench.title("numa").unit("line").batch(info.lines).epochs(5);
+    bench.run("oblivious, " + threads, [&] {
+        auto res = parse_parallel_parts(file.begin(), file.end(), n_threads, parse_simd_buf);
+        ankerl::nanobench::doNotOptimizeAway(res);
+    });
+
+    for (size_t n_nodes : { 1, 2 }) {
+        if (nodes.size() < n_nodes) {
+            std::cerr << "Only " << nodes.size() << " node(s), skipping the runs on " << n_nodes << " nodes\n";
+            continue;
+        }
+        std::vector<int> used(nodes.begin(), nodes.begin() + n_nodes);
+        std::string on_nodes = std::to_string(n_nodes) + (n_nodes == 1 ? " node, " : " nodes, ") + threads;
+
+        for (bool copy_input : { false, true }) {
+            std::string name = "numa, " + on_nodes + (copy_input ? ", copied input" : "");
+            if (!(stats_of(parse_parallel_numa(file.begin(), file.end(), n_threads, parse_simd_buf, used, copy_input)) == expected)) {
+                std::cerr << "Different result from " << name << "\n";
+            }
+            bench.run(name, [&] {
+                auto res = parse_parallel_numa(file.begin(), file.end(), n_threads, parse_simd_buf, used, copy_input);
+                ankerl::nanobench::doNotOptimizeAway(res);
+            });
+        }
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+#endif
+}
+
+// The whole ingestion, loading the file and then converting it to CSR.
+void run_csr_benchmark(std::string path, size_t entries) {
+    path = prepare_file(path, entries);
+
+    MappedFile file(path);
+    FileInfo info = get_file_info(path);
+    if (!file.ok() || info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    MatrixMarket<uint32_t> matrix;
+    if (!load_matrix_market(file.begin(), file.end(), parse_simd_buf, matrix)) {
+        std::cerr << "Not a coordinate matrix with 32-bit dimensions: " << path << "\n";
+        return;
+    }
+
+    const size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "    " << matrix.header.size.rows << " x " << matrix.header.size.cols << ", " 
+              << matrix.arrays.rows.size() << " entries, " << max_threads << " threads\n\n";
+
+    std::vector<std::pair<std::string, std::function<void(CsrMatrix<uint32_t>&)>>> builders = {
+        { "sort", [&] (CsrMatrix<uint32_t>& csr) { build_csr_sort(matrix, csr); } },
+        { "counting sort, 1 thread", [&] (CsrMatrix<uint32_t>& csr) { build_csr(matrix, 1, csr); } },
+    };
+    if (max_threads > 1) {
+        builders.emplace_back("counting sort, " + std::to_string(max_threads) + " threads", 
+                              [&] (CsrMatrix<uint32_t>& csr) { build_csr(matrix, max_threads, csr); });
+    }
+
+    CsrMatrix<uint32_t> expected;
+    build_csr_sort(matrix, expected);
+    for (const auto& [name, build] : builders) {
+        CsrMatrix<uint32_t> csr;
+        build(csr);
+        if (csr.row_ptr != expected.row_ptr || csr.col_idx != expected.col_idx) {
+            std::cerr << "Different result from " << name << "\n";
+        }
+    }
+
+    auto bench = make_bench();
+    bench.title("csr").unit("line").batch(info.lines).epochs(5);
+
+    bench.run("parse", [&] {
+        MatrixMarket<uint32_t> res;
+        load_matrix_market(file.begin(), file.end(), parse_simd_buf, res);
+        ankerl::nanobench::doNotOptimizeAway(res);
+    });
+    for (const auto& [name, build] : builders) {
+        bench.run("build only, " + name, [&] {
+            CsrMatrix<uint32_t> csr;
+            build(csr);
+            ankerl::nanobench::doNotOptimizeAway(csr);
+        });
+    }
+    // the builders work on `matrix`, so the freshly parsed one is swapped in
+    for (const auto& [name, build] : builders) {
+        bench.run("parse + " + name, [&, &build = build] {
+            MatrixMarket<uint32_t> res;
+            load_matrix_market(file.begin(), file.end(), parse_simd_buf, res);
+            std::swap(res, matrix);
+            CsrMatrix<uint32_t> csr;
+            build(csr);
+            ankerl::nanobench::doNotOptimizeAway(csr);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// From a compressed file to the CSR matrix. Decompressing to disk first (like `gunzip` would) and
+// then mapping and parsing the result, against decompressing into memory with 1 and all the threads
+// and parsing that right away. A `.gz` path is used as it is, anything else is compressed to BGZF first.
+void run_gzip_benchmark(std::string path, size_t entries) {
+#ifndef HAVE_ZLIB
+    (void)path;
+    (void)entries;
+    std::cerr << "Built without zlib, the gzip mode is not available\n";
+#else
+    std::string gz_path = path;
+    bool given = path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+    // the compressed copy (if this made one) and the unpacked file are removed at the end
+    TempFiles generated;
+    if (!given) {
+        path = prepare_file(path, entries);
+        gz_path = (std::filesystem::temp_directory_path() / std::filesystem::path(path).filename()).string() + ".gz";
+        generated.paths.push_back(gz_path);
+        std::string text = read_file(path);
+        std::cerr << "Compressing " << path << " into " << gz_path << "\n";
+        if (!write_bgzf(gz_path, text.data(), text.size())) {
+            std::cerr << "Could not write " << gz_path << "\n";
+            return;
+        }
+    }
+
+    MappedFile file(gz_path);
+    if (!file.ok()) {
+        std::cerr << "Could not read file: " << gz_path << "\n";
+        return;
+    }
+
+    const size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<GzipMember> members;
+    bool is_bgzf = find_bgzf_members(file.begin(), file.end(), members);
+
+    std::vector<char> text;
+    if (!decompress_gzip(file.begin(), file.end(), max_threads, text)) {
+        std::cerr << "Could not decompress " << gz_path << "\n";
+        return;
+    }
+    FileInfo info;
+    info.bytes = text.size();
+    info.lines = std::count(text.begin(), text.end(), '\n');
+
+    std::cerr << "File: " << gz_path << " (" << file.size() << " bytes compressed, " << info.bytes << " bytes, " 
+              << info.lines << " lines)\n";
+    std::cerr << "    " << (is_bgzf ? std::to_string(members.size()) + " BGZF members" : "not BGZF, decompressed by a single thread") 
+              << ", " << max_threads << " threads\n\n";
+
+    // the csr is built with all the threads in every case, only getting the text differs
+    auto to_csr = [&] (const char* begin, const char* end) {
+        MatrixMarket<uint32_t> matrix;
+        CsrMatrix<uint32_t> csr;
+        if (load_matrix_market(begin, end, parse_simd_buf, matrix)) {
+            build_csr(matrix, max_threads, csr);
+        }
+        return csr;
+    };
+
+    std::string unpacked_path = (std::filesystem::temp_directory_path() / "integer-parsing-unpacked.mtx").string();
+    generated.paths.push_back(unpacked_path);
+    auto via_disk = [&] {
+        {
+            std::vector<char> out;
+            inflate_gzip(file.begin(), file.end(), out);
+            std::ofstream unpacked(unpacked_path, std::ios::binary);
+            unpacked.write(out.data(), out.size());
+        }
+        MappedFile unpacked(unpacked_path);
+        return to_csr(unpacked.begin(), unpacked.end());
+    };
+    auto in_memory = [&] (size_t n_threads) {
+        std::vector<char> out;
+        decompress_gzip(file.begin(), file.end(), n_threads, out);
+        return to_csr(out.data(), out.data() + out.size());
+    };
+
+    CsrMatrix<uint32_t> expected = via_disk();
+    if (expected.row_ptr.empty()) {
+        std::cerr << "Not a coordinate matrix with 32-bit dimensions: " << gz_path << "\n";
+        return;
+    }
+    CsrMatrix<uint32_t> actual = in_memory(max_threads);
+    if (actual.row_ptr != expected.row_ptr || actual.col_idx != expected.col_idx) {
+        std::cerr << "Different result when decompressing in memory\n";
+    }
+
+    auto bench = make_bench();
+    bench.title("gzip").unit("line").batch(info.lines).epochs(3);
+
+    bench.run("decompress only, 1 thread", [&] {
+        std::vector<char> out;
+        decompress_gzip(file.begin(), file.end(), 1, out);
+        ankerl::nanobench::doNotOptimizeAway(out);
+    });
+    if (max_threads > 1) {
+        bench.run("decompress only, " + std::to_string(max_threads) + " threads", [&] {
+            std::vector<char> out;
+            decompress_gzip(file.begin(), file.end(), max_threads, out);
+            ankerl::nanobench::doNotOptimizeAway(out);
+        });
+    }
+    bench.run("to disk, then parse + csr", [&] {
+        auto res = via_disk();
+        ankerl::nanobench::doNotOptimizeAway(res);
+    });
+    bench.run("in memory, 1 thread, parse + csr", [&] {
+        auto res = in_memory(1);
+        ankerl::nanobench::doNotOptimizeAway(res);
+    });
+    if (max_threads > 1) {
+        bench.run("in memory, " + std::to_string(max_threads) + " threads, parse + csr", [&] {
+            auto res = in_memory(max_threads);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+#endif
+}
+
+// How much faster a restart is with the cache. The first run of this writes it, so the cold numbers
+// of the text are from a file which was just dropped from the page cache, same for the cache itself.
+void run_cache_benchmark(std::string path, size_t entries) {
+    constexpr size_t cold_runs = 5;
+    path = prepare_file(path, entries);
+
+    FileInfo info = get_file_info(path);
+    if (info.lines == 0) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    CachedMatrix<uint32_t> cached;
+    bool from_cache;
+    if (!load_matrix_cached(path, parse_simd_buf, cached, from_cache)) {
+        std::cerr << "Not a coordinate matrix with 32-bit dimensions: " << path << "\n";
+        return;
+    }
+    std::cerr << "File: " << path << " (" << info.lines << " lines, " << info.bytes << " bytes)\n";
+    std::cerr << "Cache: " << cache_path(path) << " (" << std::filesystem::file_size(cache_path(path)) << " bytes, "
+              << (from_cache ? "already there" : "just written") << ")\n\n";
+
+    // mapping the cache does not read anything yet, so the indices are summed up to make it fair
+    auto index_sum = [] (const uint32_t* rows, const uint32_t* cols, size_t n) {
+        size_t sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += rows[i] + cols[i];
+        }
+        return sum;
+    };
+
+    // a file which went away or changed during the run gives a sum of 0, which shows up as a different result
+    std::vector<std::pair<std::string, std::function<size_t()>>> contenders = {
+        { "parse the text", [&] {
+            MappedFile file(path);
+            MatrixMarket<uint32_t> matrix;
+            if (!file.ok() || !load_matrix_market(file.begin(), file.end(), parse_simd_buf, matrix)) {
+                return size_t(0);
+            }
+            return index_sum(matrix.arrays.rows.data(), matrix.arrays.cols.data(), matrix.arrays.rows.size());
+        } },
+        { "map the cache", [&] {
+            CachedMatrix<uint32_t> matrix;
+            if (!matrix.open(path)) {
+                return size_t(0);
+            }
+            return index_sum(matrix.rows(), matrix.cols(), matrix.entries());
+        } },
+    };
+
+    bool can_evict = evict_page_cache(path) && evict_page_cache(cache_path(path));
+    if (!can_evict) {
+        std::cerr << "Could not drop the files from the page cache, only measuring with a warm cache\n\n";
+    } else {
+        std::cout << "| cold median ms | cold min ms | benchmark\n";
+        std::cout << "|---------------:|------------:|:----------\n";
+        size_t expected = contenders.front().second();
+        for (const auto& [name, load] : contenders) {
+            std::vector<double> times;
+            for (size_t i = 0; i < cold_runs; ++i) {
+                evict_page_cache(path);
+                evict_page_cache(cache_path(path));
+                auto start = std::chrono::steady_clock::now();
+                size_t sum = load();
+                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                if (sum != expected) {
+                    std::cerr << "Different result from " << name << "\n";
+                }
+            }
+            std::sort(times.begin(), times.end());
+
+            char row[128];
+            snprintf(row, sizeof(row), "| %14.2f | %11.2f | `%s`\n", times[times.size()/2]*1e3, times.front()*1e3, name.c_str());
+            std::cout << row;
+        }
+        std::cout << "\n";
+    }
+
+    auto bench = make_bench();
+    bench.title("cache (warm)").unit("line").batch(info.lines).epochs(5);
+    for (const auto& [name, load] : contenders) {
+        bench.run(name, [&] {
+            auto res = load();
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+
+    print_throughput(bench, info);
+    collect_results(bench);
+}
+
+// Loads a batch of files one after the other like our jobs do, once with the usual vectors and once
+// with the arrays in an arena which gets reset between the files.
+void run_arena_benchmark(size_t n_files, size_t entries) {
+    auto dir = std::filesystem::temp_directory_path() / "integer-parsing-batch";
+    std::filesystem::create_directories(dir);
+    TempFiles generated{ { dir.string() } };
+    std::cerr << "Generating " << n_files << " files with " << entries << " entries each into " << dir.string() << "\n";
+
+    std::vector<std::string> paths;
+    size_t lines = 0;
+    for (size_t i = 0; i < n_files; ++i) {
+        paths.push_back((dir / (std::to_string(i) + ".mtx")).string());
+        generate_matrix_file(paths.back(), entries);
+        lines += get_file_info(paths.back()).lines;
+    }
+
+    // the same checksum for both
+    auto checksum = [] (const auto& arrays) {
+        size_t sum = arrays.empty + arrays.errors.size();
+        for (size_t i = 0; i < arrays.rows.size(); ++i) {
+            sum += arrays.rows[i] + arrays.cols[i];
+        }
+        return sum;
+    };
+
+    // kept between the runs, a job would keep it around for all of its files too
+    Arena arena;
+    // only the allocations of the index arrays are counted, the rest is the same for both
+    size_t vector_allocations = 0;
+
+    struct Contender {
+        std::string name;
+        std::function<size_t()> load;
+        std::function<size_t()> allocations;
+    };
+    std::vector<Contender> contenders = {
+        { "std::vector", [&] {
+            size_t sum = 0;
+            for (const auto& path : paths) {
+                MappedFile file(path);
+                CountingMatrixMarket<uint32_t> matrix = make_counting_matrix<uint32_t>(vector_allocations);
+                load_matrix_market(file.begin(), file.end(), parse_simd_buf, matrix);
+                sum += checksum(matrix.arrays);
+            }
+            return sum;
+        }, [&] { return vector_allocations; } },
+        { "arena", [&] {
+            size_t sum = 0;
+            for (const auto& path : paths) {
+                MappedFile file(path);
+                {
+                    ArenaMatrixMarket<uint32_t> matrix = make_arena_matrix<uint32_t>(arena);
+                    load_matrix_market(file.begin(), file.end(), parse_simd_buf, matrix);
+                    sum += checksum(matrix.arrays);
+                }
+                arena.reset();
+            }
+            return sum;
+        }, [&] { return arena.allocations(); } },
+    };
+
+    // the first run of the arena grows it to the size of the largest file, that is not what a long job sees
+    size_t expected = contenders.front().load();
+    contenders.back().load();
+
+    std::cout << "| allocations/file | page faults/file | benchmark\n";
+    std::cout << "|-----------------:|-----------------:|:----------\n";
+    for (const auto& [name, load, allocations_so_far] : contenders) {
+        size_t allocations = allocations_so_far();
+        size_t faults = page_faults();
+        size_t sum = load();
+        allocations = allocations_so_far() - allocations;
+        faults = page_faults() - faults;
+        if (sum != expected) {
+            std::cerr << "Different result from " << name << "\n";
+        }
+
+        char row[128];
+        snprintf(row, sizeof(row), "| %16.1f | %16.1f | `%s`\n", double(allocations)/n_files, double(faults)/n_files, name.c_str());
+        std::cout << row;
+    }
+    std::cout << "\n";
+
+    auto bench = make_bench();
+    bench.title("arena").unit("line").batch(lines).epochs(5);
+    for (const auto& contender : contenders) {
+        bench.run(contender.name, [&] {
+            auto res = contender.load();
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+
+    size_t bytes = 0;
+    for (const auto& path : paths) {
+        bytes += get_file_info(path).bytes;
+    }
+    print_throughput(bench, { bytes, lines });
+    collect_results(bench);
+}
+
+// Sweeps the index length, the whitespace and the amount of blank and invalid lines,
+// reporting the time per line for each implementation.
+void run_distribution_benchmark() {
+    constexpr size_t count = 10'000;
+
+    std::vector<LineDistribution> distributions;
+    for (unsigned digits : { 1, 2, 3, 4, 6, 8, 10, 12, 16, 19, 20 }) {
+        distributions.push_back({ std::to_string(digits) + " digits", digits, " ", 0 });
+    }
+    distributions.push_back({ "1-20 digits", 0, " ", 0 });
+    distributions.push_back({ "6 digits, tabs", 6, "\t", 0 });
+    distributions.push_back({ "6 digits, whitespace runs", 6, " \t   ", 0 });
+    distributions.push_back({ "6 digits, 1% bad lines", 6, " ", 1 });
+    distributions.push_back({ "6 digits, 10% bad lines", 6, " ", 10 });
+    distributions.push_back({ "6 digits, 50% bad lines", 6, " ", 50 });
+
+    for (const auto& dist : distributions) {
+        std::vector<std::string> lines = generate_lines(dist, count);
+
+        std::string buffer;
+        for (const auto& line : lines) {
+            buffer += line;
+            buffer += '\n';
+        }
+        const char* begin = buffer.data();
+        const char* end = buffer.data() + buffer.size();
+
+        auto bench = make_bench();
+        // a single iteration is 10k lines, that is too short for the epochs to be stable on their own
+        bench.title(dist.name).unit("line").batch(count).minEpochIterations(10);
+
+        auto run_lines = [&] (const char* name, auto func) {
+            bench.run(name, [&] {
+                LoadStats stats;
+                for (const auto& line : lines) {
+                    add_result(stats, func(line));
+                }
+                ankerl::nanobench::doNotOptimizeAway(stats);
+            });
+        };
+
+        auto run_buffer = [&] (const char* name, auto func) {
+            bench.run(name, [&] {
+                LoadStats stats;
+                const char* p = begin;
+                while (p < end) {
+                    add_result(stats, func(p, end, p));
+                }
+                ankerl::nanobench::doNotOptimizeAway(stats);
+            });
+        };
+
+        run_lines("stringstream", parse_string_stream);
+        run_lines("sscanf", parse_sscanf);
+        run_lines("strtoull", parse_strtoull);
+        run_lines("from_chars", parse_from_chars);
+        run_lines("custom", parse_custom);
+        run_lines("custom lut", parse_custom_lut);
+        run_lines("swar", parse_swar);
+        run_buffer("from_chars buffer", parse_from_chars_buf);
+        run_buffer("custom buffer", parse_custom_buf);
+        run_buffer("swar buffer", parse_swar_buf);
+        run_buffer("simd buffer", parse_simd_buf);
+
+        bench.run("simd batch", [&] {
+            auto stats = parse_buffer_batched<parse_simd_buf>(begin, end);
+            ankerl::nanobench::doNotOptimizeAway(stats);
+        });
+
+        print_counters(bench, buffer.size(), count);
+        collect_results(bench);
+        std::cout << "\n";
+    }
+}
+
+template<typename T>
+const char* type_name() {
+    if constexpr (std::is_same_v<T, int8_t>) return "int8_t";
+    else if constexpr (std::is_same_v<T, uint8_t>) return "uint8_t";
+    else if constexpr (std::is_same_v<T, int16_t>) return "int16_t";
+    else if constexpr (std::is_same_v<T, uint16_t>) return "uint16_t";
+    else if constexpr (std::is_same_v<T, int32_t>) return "int32_t";
+    else if constexpr (std::is_same_v<T, uint32_t>) return "uint32_t";
+    else if constexpr (std::is_same_v<T, int64_t>) return "int64_t";
+    else if constexpr (std::is_same_v<T, uint64_t>) return "uint64_t";
+    else return "?";
+}
+
+// The custom implementation against from_chars for every integer type, on lines with two random values
+// from the whole range of the type (so mostly of the full width, and half of them negative for the
+// signed ones), and on lines with two indices and a signed weight.
+void run_types_benchmark() {
+    constexpr size_t count = 10'000;
+
+    auto bench = make_bench();
+    bench.title("integer types").unit("line").batch(count).minEpochIterations(10);
+
+    auto run_pair = [&] (const std::string& type, const std::string& buffer, auto custom, auto reference) {
+        const char* begin = buffer.data();
+        const char* end = buffer.data() + buffer.size();
+        auto run = [&] (const std::string& name, auto func) {
+            bench.run(name, [&] {
+                size_t failed = 0;
+                const char* p = begin;
+                while (p < end) {
+                    auto res = func(p, end, p);
+                    failed += res.err != ErrCode::success;
+                    ankerl::nanobench::doNotOptimizeAway(res);
+                }
+                ankerl::nanobench::doNotOptimizeAway(failed);
+            });
+        };
+        run("custom " + type, custom);
+        run("from_chars " + type, reference);
+    };
+
+    auto run_type = [&] (auto zero) {
+        using T = decltype(zero);
+        std::string buffer;
+        for (size_t i = 0; i < count; ++i) {
+            buffer += random_value_string<T>() + " " + random_value_string<T>() + "\n";
+        }
+        run_pair(type_name<T>(), buffer, parse_tuple_buf<T, T>, parse_tuple_from_chars_buf<T, T>);
+    };
+
+    run_type(int8_t());
+    run_type(uint8_t());
+    run_type(int16_t());
+    run_type(uint16_t());
+    run_type(int32_t());
+    run_type(uint32_t());
+    run_type(int64_t());
+    run_type(uint64_t());
+
+    std::string weighted;
+    for (size_t i = 0; i < count; ++i) {
+        weighted += std::to_string(std::uniform_int_distribution<uint32_t>(1, 9'999'999)(mt)) + " " 
+                  + std::to_string(std::uniform_int_distribution<uint32_t>(1, 9'999'999)(mt)) + " " 
+                  + std::to_string(std::uniform_int_distribution<int64_t>(-100'000, 100'000)(mt)) + "\n";
+    }
+    run_pair("tuple<uint32_t, uint32_t, int64_t>", weighted, parse_tuple_buf<uint32_t, uint32_t, int64_t>, 
+             parse_tuple_from_chars_buf<uint32_t, uint32_t, int64_t>);
+
+    collect_results(bench);
+}
+
+// nanobench runs every contender over and over, so everything it touches stays in the caches and a
+// single slow epoch disappears in the median. Here every epoch is a single pass over the lines, timed on
+// its own, once back to back and once with the caches flushed before every pass. The distribution over
+// the epochs is reported for both, and for nanobench's own epochs of the warm run.
+void run_cold_benchmark(size_t count, size_t epochs) {
+    if (count == 0 || epochs == 0) {
+        std::cerr << "Need at least one line and one epoch\n";
+        return;
+    }
+    LineDistribution dist = { "1-20 digits, 1% bad lines", 0, " ", 1 };
+    std::vector<std::string> lines = generate_lines(dist, count);
+
+    std::string buffer;
+    for (const auto& line : lines) {
+        buffer += line;
+        buffer += '\n';
+    }
+    const char* begin = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+
+    std::vector<std::pair<std::string, std::function<LoadStats()>>> contenders;
+    auto add_lines = [&] (const char* name, auto func) {
+        contenders.emplace_back(name, [&lines, func] {
+            LoadStats stats;
+            for (const auto& line : lines) {
+                add_result(stats, func(line));
+            }
+            return stats;
+        });
+    };
+    auto add_buffer = [&] (const char* name, auto func) {
+        contenders.emplace_back(name, [begin, end, func] {
+            LoadStats stats;
+            const char* p = begin;
+            while (p < end) {
+                add_result(stats, func(p, end, p));
+            }
+            return stats;
+        });
+    };
+
+    add_lines("stringstream", parse_string_stream);
+    add_lines("sscanf", parse_sscanf);
+    add_lines("strtoull", parse_strtoull);
+    add_lines("from_chars", parse_from_chars);
+    add_lines("custom", parse_custom);
+    add_buffer("custom buffer", parse_custom_buf);
+    add_buffer("swar buffer", parse_swar_buf);
+    add_buffer("simd buffer", parse_simd_buf);
+
+    std::cerr << dist.name << ", " << count << " lines, " << buffer.size() << " bytes, " << epochs << " epochs\n";
+
+    for (bool cold : { false, true }) {
+        print_distribution_header(cold ? "caches flushed before every epoch" : "back to back");
+        for (const auto& [name, load] : contenders) {
+            std::vector<double> times;
+            for (size_t i = 0; i < epochs; ++i) {
+                if (cold) {
+                    evict_caches();
+                }
+                auto start = std::chrono::steady_clock::now();
+                LoadStats stats = load();
+                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                ankerl::nanobench::doNotOptimizeAway(stats);
+            }
+            print_distribution_row(epoch_distribution(times), double(count), name);
+        }
+    }
+    std::cout << "\n";
+
+    auto bench = make_bench();
+    bench.title(dist.name).unit("line").batch(count).epochs(51).minEpochIterations(10);
+    for (const auto& [name, load] : contenders) {
+        bench.run(name, [&] {
+            auto res = load();
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+    }
+
+    print_epochs(bench);
+    print_counters(bench, double(buffer.size()), double(count));
+    collect_results(bench);
+}
+
+// Parses the first 1K, 4K, ... lines of a generated file with each of the loaders and fits the
+// complexity curves to the times. Anything that grows faster than O(n) means that there is something
+// like regrowing vectors or data spilling out of the caches going on.
+void run_scaling_benchmark(size_t max_lines) {
+    std::string path = prepare_file("", max_lines);
+    MappedFile file(path);
+    if (!file.ok()) {
+        std::cerr << "Could not read file: " << path << "\n";
+        return;
+    }
+
+    // the prefixes keep the header, so the loaders see a valid (if slightly lying) file, the last one
+    // is the whole file, so any max lines is measured up to its value
+    std::vector<std::pair<size_t, const char*>> prefixes;
+    const char* p = skip_header(file.begin(), file.end());
+    size_t lines = 0;
+    for (size_t n = 1024; n < max_lines; n *= 4) {
+        for (; lines < n && p < file.end(); ++lines) {
+            p = next_line(find_line_end(p, file.end()), file.end());
+        }
+        prefixes.emplace_back(lines, p);
+    }
+    for (; p < file.end(); ++lines) {
+        p = next_line(find_line_end(p, file.end()), file.end());
+    }
+    if (prefixes.empty() || prefixes.back().first < lines) {
+        prefixes.emplace_back(lines, p);
+    }
+
+    auto run_sizes = [&] (const char* name, auto load) {
+        auto bench = make_bench();
+        bench.title(name).unit("line").epochs(5);
+
+        for (const auto& [n, end] : prefixes) {
+            bench.complexityN(n).batch(n).run(std::to_string(n) + " lines", [&] {
+                auto res = load(file.begin(), end);
+                ankerl::nanobench::doNotOptimizeAway(res);
+            });
+        }
+
+        std::cout << "\n" << bench.complexityBigO() << "\n";
+        collect_results(bench);
+    };
+
+    run_sizes("from_chars buffer", [] (const char* begin, const char* end) {
+        return parse_buffer(begin, end, parse_from_chars_buf);
+    });
+    run_sizes("custom buffer", [] (const char* begin, const char* end) {
+        return parse_buffer(begin, end, parse_custom_buf);
+    });
+    run_sizes("simd buffer", [] (const char* begin, const char* end) {
+        return parse_buffer(begin, end, parse_simd_buf);
+    });
+    run_sizes("vector<Result>", [] (const char* begin, const char* end) {
+        return load_results(begin, end, parse_simd_buf);
+    });
+    run_sizes("index arrays", [] (const char* begin, const char* end) {
+        AnyIndexArrays res;
+        load_index_arrays(begin, end, parse_simd_buf, res);
+        return res;
+    });
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+//                                                                                // 
+//                                    MAIN                                        //
+//                                                                                //
+////////////////////////////////////////////////////////////////////////////////////
+
+void run_tests() {
+    test_parse_func(parse_string_stream, "stringstream");
+    test_parse_func(parse_custom, "custom");
+    test_parse_func(parse_sscanf, "sscanf");
+    test_parse_func(parse_strtoull, "strtoull");
+    test_parse_func(parse_from_chars, "from_chars");
+    test_parse_func(parse_from_chars_lut, "from_chars lut");
+    test_parse_func(parse_custom_lut, "custom lut");
+
+    // test overflows in a bit more detailed way for my custom implementation just to be sure
+    test_overflow(parse_custom, "custom");
+    test_overflow(parse_custom_lut, "custom lut");
+
+    test_buffer_func(parse_string_stream_buf, "stringstream buffer");
+    test_buffer_func(parse_custom_buf, "custom buffer");
+    test_buffer_func(parse_sscanf_buf, "sscanf buffer");
+    test_buffer_func(parse_strtoull_buf, "strtoull buffer");
+    test_buffer_func(parse_from_chars_buf, "from_chars buffer");
+
+    test_parse_func(parse_swar, "swar");
+    test_buffer_func(parse_swar_buf, "swar buffer");
+    test_buffer_func(parse_custom_skip_buf, "custom skip buffer");
+    test_buffer_func(parse_swar_skip_buf, "swar skip buffer");
+    test_value_func();
+
+    test_overflow(as_string_func(parse_custom_buf), "custom buffer");
+    test_overflow(parse_swar, "swar");
+    test_overflow(as_string_func(parse_swar_skip_buf), "swar skip buffer");
+
+#ifdef HAVE_X86_SIMD
+    if (cpu_has_sse42()) {
+        test_simd_func(parse_sse42_buf, "sse4.2 buffer");
+    }
+    if (cpu_has_avx2()) {
+        test_simd_func(parse_avx2_buf, "avx2 buffer");
+    }
+#endif
+    test_parse_func(parse_simd, "simd");
+    test_simd_func(parse_simd_buf, "simd buffer");
+
+    test_buffer_func(parse_typed_buf<uint64_t>, "fields<uint64_t, 2>");
+    test_overflow(as_string_func(parse_typed_buf<uint64_t>), "fields<uint64_t, 2>");
+    test_fields_funcs();
+    test_typed_funcs();
+    test_batch_func<parse_custom_buf>("custom batch");
+    test_batch_func<parse_simd_buf>("simd batch");
+    test_differential();
+    test_generate_lines();
+
+    test_matrix_market();
+    test_optimistic();
+    test_stream_file();
+    test_work_stealing();
+    test_queue();
+#ifdef HAVE_NUMA
+    test_numa();
+#endif
+    test_csr();
+    test_binary_cache();
+    test_arena();
+#ifdef HAVE_ZLIB
+    test_gzip();
+#endif
+
+    std::cerr << "\n";
+}
+
+void run_line_benchmark() {
+    std::string test_str = "236514 159854 25.01564 ";
+
+    auto bench = make_bench();
+
+    // on windows pyperf can't help us to setup the system for benechmarks
+    // so the benchmark is quite unstable and we have to use more iterations
+#ifdef _WIN32
+    bench = bench.minEpochIterations(200'000);
+#endif
+        
+    bench
+        .run("stringstream", [&] {
+            auto res = parse_string_stream(test_str);    
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("sscanf", [&] {
+            auto res = parse_sscanf(test_str);    
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("strtoull", [&] {
+            auto res = parse_strtoull(test_str);    
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("from_chars", [&] {
+            auto res = parse_from_chars(test_str);    
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("custom", [&] {
+            auto res = parse_custom(test_str);    
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("from_chars lut", [&] {
+            auto res = parse_from_chars_lut(test_str);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("custom lut", [&] {
+            auto res = parse_custom_lut(test_str);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("swar", [&] {
+            auto res = parse_swar(test_str);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("simd", [&] {
+            auto res = parse_simd(test_str);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+
+    const char* begin = test_str.data();
+    const char* end = test_str.data() + test_str.size();
+    const char* next;
+
+    bench
+        .run("stringstream buffer", [&] {
+            auto res = parse_string_stream_buf(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("sscanf buffer", [&] {
+            auto res = parse_sscanf_buf(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("strtoull buffer", [&] {
+            auto res = parse_strtoull_buf(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("from_chars buffer", [&] {
+            auto res = parse_from_chars_buf(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("custom buffer", [&] {
+            auto res = parse_custom_buf(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("swar buffer", [&] {
+            auto res = parse_swar_buf(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+
+    // the simd kernels need some more buffer behind the line to not fall back to the custom implementation
+    std::string padded_str = test_str + "\n" + std::string(64, ' ');
+    const char* padded_begin = padded_str.data();
+    const char* padded_end = padded_str.data() + padded_str.size();
+
+    bench.run(std::string("simd buffer (") + simd_kernel.name + ")", [&] {
+        auto res = parse_simd_buf(padded_begin, padded_end, next);
+        ankerl::nanobench::doNotOptimizeAway(res);
+    });
+
+    std::string tensor_str = "236514 159854 12 25.01564 ";
+    const char* tensor_begin = tensor_str.data();
+    const char* tensor_end = tensor_str.data() + tensor_str.size();
+
+    bench
+        .run("fields<uint32_t, 2>", [&] {
+            auto res = parse_fields_buf<uint32_t, 2>(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("fields<uint64_t, 2>", [&] {
+            auto res = parse_fields_buf<uint64_t, 2>(begin, end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("fields<uint32_t, 3>", [&] {
+            auto res = parse_fields_buf<uint32_t, 3>(tensor_begin, tensor_end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        })
+        .run("fields<uint64_t, 3>", [&] {
+            auto res = parse_fields_buf<uint64_t, 3>(tensor_begin, tensor_end, next);
+            ankerl::nanobench::doNotOptimizeAway(res);
+        });
+
+    // some of the inputs are a few characters longer, but that does not matter much
+    print_counters(bench, test_str.size(), 1);
+    collect_results(bench);
+}
+
+// The differential test from run_tests on a lot more lines, in rounds so the memory stays bounded.
+// Prints how many lines per second were checked, so it is easy to pick a count which fits the time
+// there is in a nightly run.
+bool run_fuzz(size_t total, uint32_t seed) {
+    constexpr size_t round_size = 100'000;
+    mt.seed(seed);
+
+    Differences diffs;
+    size_t kernels = 0;
+    size_t outcomes[3] = {};
+    std::vector<std::string> lines;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t done = 0; done < total; done += lines.size()) {
+        lines.resize(std::min(round_size, total - done));
+        for (auto& line : lines) {
+            line = random_line();
+            ++outcomes[static_cast<int>(parse_from_chars(line).err)];
+        }
+        kernels = run_differential(lines, diffs);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char line[256];
+    snprintf(line, sizeof(line), "checked %zu lines (seed %u) on %zu implementations in %.2f s, %.0f lines/s\n",
+             total, seed, kernels, seconds, total / seconds);
+    std::cout << line;
+    std::cout << "from_chars says: " << outcomes[static_cast<int>(ErrCode::success)] << " success, "
+              << outcomes[static_cast<int>(ErrCode::empty)] << " empty, "
+              << outcomes[static_cast<int>(ErrCode::error)] << " error\n";
+    std::cout << diffs.count << " differences\n";
+    return diffs.count == 0;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage:\n";
+    std::cerr << "    " << program << "                                parse a single line over and over\n";
+    std::cerr << "    " << program << " distributions                  different index lengths, whitespace and bad lines\n";
+    std::cerr << "    " << program << " types                          custom against from_chars for 8 to 64 bit integers\n";
+    std::cerr << "    " << program << " cold [lines] [epochs]          per epoch distribution, warm and with flushed caches\n";
+    std::cerr << "    " << program << " scaling [max lines]            fit the complexity of parsing 1K up to 16M lines\n";
+    std::cerr << "    " << program << " file [path|-] [entries]        load a whole file, generated if no path is given\n";
+    std::cerr << "    " << program << " io [path|-] [entries]          compare ifstream, fread and mmap for reading the file\n";
+    std::cerr << "    " << program << " threads [path|-] [entries]     parse the file with 1 to hardware_concurrency threads\n";
+    std::cerr << "    " << program << " steal [path|-] [entries]       static chunks against work stealing on a skewed file\n";
+    std::cerr << "    " << program << " output [path|-] [entries]      compare vector<Result> with separate row/col arrays\n";
+    std::cerr << "    " << program << " header [path|-] [entries]      pre-size the arrays from the matrix market header\n";
+    std::cerr << "    " << program << " optimistic [path|-] [entries]  parse first, diagnose the failed lines afterwards\n";
+    std::cerr << "    " << program << " stream [path|-] [entries]      stream through a fixed buffer, throughput and peak memory\n";
+    std::cerr << "    " << program << " pipeline [path|-] [entries]    overlap reading and parsing, also with a cold page cache\n";
+    std::cerr << "    " << program << " queue [path|-] [entries]       consume the entries through a queue while parsing\n";
+    std::cerr << "    " << program << " numa [path|-] [entries]        bind the threads and their output to numa nodes\n";
+    std::cerr << "    " << program << " csr [path|-] [entries]         load the matrix and convert it to CSR\n";
+    std::cerr << "    " << program << " gzip [path|-] [entries]        compressed file to CSR, via the disk or in memory\n";
+    std::cerr << "    " << program << " cache [path|-] [entries]       parse the text against mapping the binary cache\n";
+    std::cerr << "    " << program << " arena [files] [entries]        load a batch of files into vectors or an arena\n";
+    std::cerr << "    " << program << " fuzz [lines] [seed]            compare all implementations on random lines (1M)\n";
+    std::cerr << "    " << program << " compare <baseline> <current>   flag contenders which got slower than their err%\n";
+    std::cerr << "\n";
+    std::cerr << "Any of the benchmarks also accept --export <dir> to write the results as csv and json\n";
+    std::cerr << "and --pin <core> to run on that core only, together with all the threads they start.\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--export" && i + 1 < argc) {
+            export_dir = argv[++i];
+        } else if (std::string(argv[i]) == "--pin" && i + 1 < argc) {
+            unsigned core = std::stoul(argv[++i]);
+            if (!pin_to_core(core)) {
+                std::cerr << "Could not pin the benchmark to core " << core << "\n";
+                return 1;
+            }
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    std::string mode = args.size() > 0 ? args[0] : "line";
+
+    if (mode == "compare") {
+        if (args.size() != 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return compare_results(args[1], args[2]) ? 0 : 1;
+    }
+
+    run_tests();
+
+    if (mode == "line") {
+        run_line_benchmark();
+    } else if (mode == "distributions") {
+        run_distribution_benchmark();
+    } else if (mode == "arena") {
+        size_t n_files = args.size() > 1 ? std::stoull(args[1]) : 100;
+        run_arena_benchmark(n_files, args.size() > 2 ? std::stoull(args[2]) : 20'000);
+    } else if (mode == "types") {
+        run_types_benchmark();
+    } else if (mode == "cold") {
+        size_t lines = args.size() > 1 ? std::stoull(args[1]) : 10'000;
+        run_cold_benchmark(lines, args.size() > 2 ? std::stoull(args[2]) : 101);
+    } else if (mode == "fuzz") {
+        size_t lines = args.size() > 1 ? std::stoull(args[1]) : 1'000'000;
+        return run_fuzz(lines, args.size() > 2 ? std::stoul(args[2]) : std::random_device{}()) ? 0 : 1;
+    } else if (mode == "scaling") {
+        run_scaling_benchmark(args.size() > 1 ? std::stoull(args[1]) : 16 << 20);
+    } else {
+        // all the other modes work with a file
+        std::string path = args.size() > 1 ? args[1] : "";
+        size_t entries = args.size() > 2 ? std::stoull(args[2]) : 2'000'000;
+
+        if (mode == "file") {
+            run_file_benchmark(path, entries);
+        } else if (mode == "io") {
+            run_io_benchmark(path, entries);
+        } else if (mode == "threads") {
+            run_threads_benchmark(path, entries);
+        } else if (mode == "steal") {
+            run_steal_benchmark(path, entries);
+        } else if (mode == "output") {
+            run_output_benchmark(path, entries);
+        } else if (mode == "header") {
+            run_header_benchmark(path, entries);
+        } else if (mode == "optimistic") {
+            run_optimistic_benchmark(path, entries);
+        } else if (mode == "stream") {
+            run_stream_benchmark(path, entries);
+        } else if (mode == "pipeline") {
+            run_pipeline_benchmark(path, entries);
+        } else if (mode == "queue") {
+            run_queue_benchmark(path, entries);
+        } else if (mode == "numa") {
+            run_numa_benchmark(path, entries);
+        } else if (mode == "csr") {
+            run_csr_benchmark(path, entries);
+        } else if (mode == "gzip") {
+            run_gzip_benchmark(path, entries);
+        } else if (mode == "cache") {
+            run_cache_benchmark(path, entries);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef BENCH_STAGE_STATS
+    print_stage_stats();
+#endif
+    if (!export_dir.empty() && !export_results(mode)) {
+        return 1;
+    }
 }